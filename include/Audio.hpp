@@ -1,6 +1,15 @@
 #pragma once
 
 #include "Config.hpp"
+#include "SampleData.hpp"
+#include "SampleCache.hpp"
+#include "Output.hpp"
+#include "Recorder.hpp"
+#include "VoiceKernel.hpp"
+#include "Meter.hpp"
+#include "Effects.hpp"
+#include "Realtime.hpp"
+#include "MidiEvent.hpp"
 
 #include <vector>
 #include <array>
@@ -9,25 +18,56 @@
 #include <cstdint>
 #include <memory>
 
-#include <portaudio.h>
 #include <sndfile.h>
 #include <kiss_fft.h>
 
 class Audio {
 public:
-    Audio();
+    // effectBypass is EffectChain's bypass mask, in place before the output starts
+    Audio(std::unique_ptr<Output> output, float sampleRate, const RealtimeConfig& realtime = {},
+          uint32_t effectBypass = 0);
     ~Audio();
 
     Audio(const Audio&) = delete;
     Audio& operator=(const Audio&) = delete;
 
-    void noteOn(uint8_t key, uint8_t velocity);
-    void percOn(uint8_t idx, uint8_t velocity);
-    void pitchBend(uint8_t value);
+    // The single way input reaches the engine, applied in order
+    void handleEvents(const MidiEvent* events, size_t count);
 
     bool loadSample(const char* path);
     bool loadPercSample(uint8_t idx, const char* path);
 
+    void setSampleStorage(SampleStorage storage);
+
+    // Resampling quality for notes started from now on
+    void setPianoInterpolation(Interpolation interp);
+    void setPercInterpolation(uint8_t idx, Interpolation interp);
+
+    // Stops the current output and starts the new one, which must run at sampleRate()
+    void setOutput(std::unique_ptr<Output> output);
+    float sampleRate() const { return sampleRate_; }
+    unsigned long outputFrames() const;
+    uint64_t outputXruns() const;
+    bool outputFailed() const; // also after checkOutput stood in for it, until the next setOutput
+
+    // Replaces an output that failed for good with a null one at the same settings, so the
+    // engine keeps running and says so instead of sitting on a dead stream. False if it did.
+    bool checkOutput();
+
+    // Highest share of the block period spent rendering since the last call
+    float takePeakLoad();
+
+    Recorder& recorder() { return recorder_; }
+    SampleCache& sampleCache() { return cache_; }
+    EffectChain& effects() { return effects_; }
+
+    static constexpr size_t METER_MASTER = 0;
+    static constexpr size_t METER_PIANO = 1;
+    static constexpr size_t METER_PERC = 2; // first of cfg::NUM_PERC pad meters
+    static constexpr size_t NUM_METERS = METER_PERC + cfg::NUM_PERC;
+
+    MeterLevel takeMeter(size_t meter);
+
     void computeSpectrum();
     std::vector<float> getSpectrumCopy() const;
 
@@ -38,36 +78,42 @@ public:
     void decayPercOnce();
 
 private:
+    // Voices keep the sample they started on alive, plus the pyramid level and kernel picked for it
     struct Voice {
         int key;
-        float pos;
+        std::shared_ptr<const SampleData> sample;
+        const SampleData* level;
+        const VoiceKernel* kernel;
+        double pos;
         float increment;
         float velocity;
+        float bend;
         bool alive;
     };
 
     struct PercVoice {
         int idx;
-        float pos;
+        std::shared_ptr<const SampleData> sample;
+        const SampleData* level;
+        const VoiceKernel* kernel;
+        double pos;
         float increment;
         float velocity;
+        float bend;
         bool alive;
     };
 
     struct Sample {
-        std::vector<float> data;
+        std::shared_ptr<const SampleData> data;
         mutable std::mutex mutex;
-        std::atomic<bool> loaded = false;
-        int rate = cfg::DEFAULT_WAV_SAMPLE_RATE;
-        int channels = cfg::DEFAULT_WAV_CHANNELS;
+        std::atomic<Interpolation> interpolation = Interpolation::Linear;
+
+        std::shared_ptr<const SampleData> get() const;
     };
 
-    static int paCallback(const void* input, void* output,
-                          unsigned long framesPerBuffer,
-                          const PaStreamCallbackTimeInfo* timeInfo,
-                          PaStreamCallbackFlags statusFlags,
-                          void* userData);
-    int processAudio(void* outputBuffer, unsigned long framesPerBuffer);
+    void processAudio(float* outputBuffer, unsigned long framesPerBuffer);
+
+    SampleCache cache_;
 
     Sample pianoSample_;
     std::vector<Voice> activeVoices_;
@@ -87,9 +133,32 @@ private:
     std::array<uint8_t, cfg::NUM_PERC> perc_;
     std::atomic<uint8_t> pitch_;
 
-    PaStream* stream_;
+    std::atomic<SampleStorage> storage_;
+
+    std::vector<float> mixBuffer_;
+    std::vector<float> groupBuffer_;
+    std::array<Meter, NUM_METERS> meters_;
+    std::vector<float> decodeBuffer_;
+
+    const float sampleRate_;
+    const RealtimeConfig realtime_;
+    EffectChain effects_;
+    std::atomic<float> peakLoad_;
+
+    // Written by the rendering thread as it starts, read once threadReady_ is set
+    RealtimeStatus threadStatus_;
+    std::atomic<bool> threadReady_;
+
+    Recorder recorder_;
+
+    std::unique_ptr<Output> output_;
+    bool replacedFailed_; // output_ is checkOutput's stand-in, guarded by outputMutex_
+    mutable std::mutex outputMutex_;
 
+    void startOutput(std::unique_ptr<Output> output); // outputMutex_ held
     void initHannWindow();
     float pitchBendFactor() const;
+    bool makeVoice(uint8_t key, uint8_t velocity, Voice& v);
+    bool makePercVoice(uint8_t idx, uint8_t velocity, PercVoice& pv);
     float frequencyFromMidi(int key) const;
 };
@@ -0,0 +1,5 @@
+#pragma once
+
+// Renders synthetic voices through every interpolation mode and storage format
+// and prints how many voices one core sustains in real time. Returns an exit code.
+int runBenchmark(float sampleRate);
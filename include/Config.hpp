@@ -1,15 +1,72 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 namespace cfg {
 
 constexpr int NUM_KEYS = 121;
 constexpr int NUM_PERC = 8;
-constexpr int DEFAULT_WAV_SAMPLE_RATE = 44100;
-constexpr int DEFAULT_WAV_CHANNELS = 1;
-constexpr float OUTPUT_SAMPLE_RATE = 44100.f;
-constexpr int PA_FRAMES = 256;
+// Notes the pads send, in pad order, on the drum channel or the pad cable of the USB device
+constexpr uint8_t PAD_NOTES[NUM_PERC] = { 0x28, 0x29, 0x2a, 0x2b, 0x30, 0x31, 0x32, 0x33 };
+constexpr uint8_t MIDI_DRUM_CHANNEL = 9;
+constexpr uint8_t USB_PAD_CABLE = 2;
+constexpr float DEFAULT_OUTPUT_SAMPLE_RATE = 44100.f;
+constexpr int DEFAULT_OUTPUT_FRAMES = 256;
+constexpr int MIX_FRAMES = 256;
+constexpr float MASTER_GAIN = 0.2f;
+constexpr int DECODE_FRAMES = 4096;
+
+constexpr int SINC_TAPS = 16;
+constexpr int SINC_PHASES = 256;
+constexpr double SINC_CUTOFF = 0.92;
+// One sinc table per step range, the cutoff lowered to SINC_CUTOFF / step so that
+// reading faster than one frame per output frame does not alias. Steps above the
+// last entry use its table.
+constexpr float SINC_TABLE_STEPS[] = { 1.f, 1.25f, 1.5f, 2.f, 3.f };
+constexpr double SINC_KAISER_BETA = 8.0;
+
+constexpr size_t SAMPLE_CACHE_MB = 512;
+
+constexpr int MIP_MAX_LEVELS = 6;
+constexpr int MIP_MIN_FRAMES = 64;
+constexpr int MIP_FILTER_TAPS = 31;
+constexpr float MIP_MAX_STEP = 1.41421356f;
+
+constexpr int RT_AUDIO_PRIORITY = 80;
+constexpr int RT_INPUT_PRIORITY = 70;
+
+constexpr int TUNE_MIN_FRAMES = 32;
+constexpr int TUNE_MAX_FRAMES = 2048;
+constexpr int TUNE_SECONDS = 5;
+constexpr float TUNE_MAX_LOAD = 0.7f;
+
+constexpr int RECORD_RING_SECONDS = 10;
+constexpr int RECORD_DRAIN_MS = 50;
+
+// Rendered past the last replayed event in --headless so releases and tails ring out
+constexpr int HEADLESS_TAIL_SECONDS = 3;
+
+// Master effects, applied after MASTER_GAIN in this order
+constexpr float EQ_HIGHPASS_HZ = 30.f;
+constexpr float EQ_LOW_SHELF_HZ = 200.f;
+constexpr float EQ_LOW_SHELF_DB = -2.f;
+constexpr float EQ_HIGH_SHELF_HZ = 8000.f;
+constexpr float EQ_HIGH_SHELF_DB = 2.f;
+
+constexpr float DELAY_MS = 375.f;
+constexpr float DELAY_MAX_MS = 2000.f;
+constexpr float DELAY_FEEDBACK = 0.35f;
+constexpr float DELAY_DAMPING = 0.3f;
+constexpr float DELAY_MIX = 0.2f;
+
+constexpr float REVERB_ROOM = 0.8f;
+constexpr float REVERB_DAMPING = 0.3f;
+constexpr float REVERB_WET = 0.2f;
+constexpr float REVERB_WIDTH = 1.f;
+
+constexpr float LIMITER_CEILING = 0.98f;
+constexpr float LIMITER_RELEASE_MS = 80.f;
 
 constexpr int FFT_SIZE = 8192;
 constexpr float SMOOTHING_FACTOR = 0.75f;
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Master insert effect working in place on interleaved stereo, one mix block at a time.
+// process is called on the audio thread and must not allocate, lock or make syscalls.
+class Effect {
+public:
+    virtual ~Effect() = default;
+
+    virtual const char* name() const = 0;
+    virtual void process(float* data, size_t frames) = 0; // frames <= cfg::MIX_FRAMES
+
+    // Back to silence, so an effect returning from bypass does not replay a stale tail.
+    // Called on the audio thread like process.
+    virtual void reset() = 0;
+};
+
+// Second order section, coefficients normalized so that a0 = 1
+struct Biquad {
+    enum class Type { HighPass, LowShelf, Peak, HighShelf };
+
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+
+    static Biquad design(Type type, float sampleRate, float hz, float gainDb, float q);
+};
+
+// Cascade of biquads, both channels of a frame filtered together
+class EqEffect : public Effect {
+public:
+    explicit EqEffect(float sampleRate);
+
+    static constexpr const char* NAME = "eq";
+
+    const char* name() const override { return NAME; }
+    void process(float* data, size_t frames) override;
+    void reset() override;
+
+private:
+    static constexpr size_t BANDS = 3;
+
+    std::array<Biquad, BANDS> bands_;
+    alignas(16) float state_[BANDS][2][4]; // z1 and z2, left and right in the low lanes
+};
+
+// Stereo feedback delay with a lowpass in the feedback path
+class DelayEffect : public Effect {
+public:
+    explicit DelayEffect(float sampleRate);
+
+    static constexpr const char* NAME = "delay";
+
+    const char* name() const override { return NAME; }
+    void process(float* data, size_t frames) override;
+    void reset() override;
+
+private:
+    std::vector<float> buffer_; // interleaved, a power of two frames long
+    size_t mask_;
+    size_t write_;
+    size_t delay_;
+    float lowpass_[2];
+};
+
+// Schroeder-Moorer reverb in the Freeverb layout, eight damped combs and four allpasses per channel
+class ReverbEffect : public Effect {
+public:
+    explicit ReverbEffect(float sampleRate);
+
+    static constexpr const char* NAME = "reverb";
+
+    const char* name() const override { return NAME; }
+    void process(float* data, size_t frames) override;
+    void reset() override;
+
+private:
+    static constexpr size_t COMBS = 8;
+    static constexpr size_t ALLPASSES = 4;
+
+    struct Comb {
+        std::vector<float> buffer;
+        size_t pos = 0;
+        float store = 0.f;
+    };
+
+    struct Allpass {
+        std::vector<float> buffer;
+        size_t pos = 0;
+    };
+
+    std::array<std::array<Comb, COMBS>, 2> combs_;
+    std::array<std::array<Allpass, ALLPASSES>, 2> allpasses_;
+
+    std::array<float, cfg::MIX_FRAMES> input_;
+    std::array<std::array<float, cfg::MIX_FRAMES>, 2> wet_;
+};
+
+// Peak limiter without look-ahead: instant attack, so the output never exceeds the ceiling
+class LimiterEffect : public Effect {
+public:
+    explicit LimiterEffect(float sampleRate);
+
+    static constexpr const char* NAME = "limiter";
+
+    const char* name() const override { return NAME; }
+    void process(float* data, size_t frames) override;
+    void reset() override;
+
+private:
+    float release_;
+    float envelope_;
+};
+
+// The master insert chain: eq, delay, reverb, limiter. Bypass and the
+// counters may be used from any thread, process only from the audio thread.
+class EffectChain {
+public:
+    static constexpr size_t NUM_EFFECTS = 4;
+    static constexpr size_t LIMITER = 3; // last, so the master can be metered just before it
+
+    // bypass has bit i set for each effect i that starts bypassed
+    explicit EffectChain(float sampleRate, uint32_t bypass = 0);
+
+    // Runs the effects first..last-1 that are not bypassed
+    void process(float* data, size_t frames, size_t first = 0, size_t last = NUM_EFFECTS);
+
+    size_t size() const { return NUM_EFFECTS; }
+    const char* name(size_t idx) const { return effects_[idx]->name(); }
+    static int find(std::string_view name); // -1 if there is none
+
+    // In chain order, the constructor builds the effects in the same order
+    static constexpr const char* NAMES[NUM_EFFECTS] = { EqEffect::NAME, DelayEffect::NAME,
+                                                        ReverbEffect::NAME, LimiterEffect::NAME };
+
+    void setBypass(size_t idx, bool bypass);
+    bool bypassed(size_t idx) const { return bypass_.load(std::memory_order_relaxed) & (1u << idx); }
+
+    // Time spent in an effect and the audio it processed in that time, since startup
+    uint64_t cpuNanoseconds(size_t idx) const { return stats_[idx].nanoseconds.load(std::memory_order_relaxed); }
+    uint64_t framesProcessed(size_t idx) const { return stats_[idx].frames.load(std::memory_order_relaxed); }
+
+    // Prints each effect's state and its share of the real-time budget
+    void report() const;
+
+private:
+    struct Stats {
+        std::atomic<uint64_t> nanoseconds = 0;
+        std::atomic<uint64_t> frames = 0;
+    };
+
+    const float sampleRate_;
+    std::array<std::unique_ptr<Effect>, NUM_EFFECTS> effects_;
+    std::array<Stats, NUM_EFFECTS> stats_;
+    std::atomic<uint32_t> bypass_;
+    uint32_t processedBypass_; // bypass mask process last ran with, audio thread only
+};
@@ -21,6 +21,7 @@ public:
 
     static void dropCallbackStatic(GLFWwindow* window, int count, const char** paths);
     static void cursorPosCallbackStatic(GLFWwindow* window, double xpos, double ypos);
+    static void keyCallbackStatic(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 private:
     Audio& audio_;
@@ -29,10 +30,13 @@ private:
     std::array<std::array<float,3>, cfg::NUM_PERC> percColors_;
     double mouseX_, mouseY_;
 
+    std::array<MeterLevel, Audio::NUM_METERS> meterDisplay_;
+
     void drawFrame();
     void fillRect(float x, float y, float w, float h, float r, float g, float b);
     void drawKey(float x, float y, float w, float h, float r, float g, float b, bool border = true);
     void drawPerc(float x, float y, float w, float h, float r, float g, float b, float v);
+    void drawMeter(float x, float y, float w, float h, const MeterLevel& level);
 
     static Graphics* s_instance_;
 };
@@ -0,0 +1,7 @@
+#pragma once
+
+// Modified Bessel function of the first kind, order zero, by its power series
+double besselI0(double x);
+
+// Kaiser window at t in [-1, 1] from the centre, 1 there and falling off with beta
+double kaiserWindow(double t, double beta);
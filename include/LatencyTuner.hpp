@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Audio.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+
+// Steps the output buffer up from cfg::TUNE_MIN_FRAMES until a whole
+// cfg::TUNE_SECONDS window passes without xruns and under cfg::TUNE_MAX_LOAD
+class LatencyTuner {
+public:
+    LatencyTuner(Audio& audio, std::string outputSpec);
+
+    void run();
+
+    // Makes run() return early, from any thread
+    void stop();
+
+private:
+    Audio& audio_;
+    std::string outputSpec_;
+
+    std::atomic<bool> stopped_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+
+    bool tryFrames(unsigned long frames);
+    bool switchTo(unsigned long frames);
+    bool wait(std::chrono::milliseconds duration); // false once stopped
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+struct MeterLevel {
+    float peak;
+    float rms;
+};
+
+// Block levels published by the audio thread and read by the GUI without locks
+class Meter {
+public:
+    void publish(float peak, float sumSquares, size_t samples);
+
+    // Highest peak since the last call and the RMS of the latest block
+    MeterLevel take();
+
+private:
+    std::atomic<float> peak_ = 0.f;
+    std::atomic<float> rms_ = 0.f;
+};
+
+// dst += src while measuring src, vectorized
+void accumulateMeasured(float* dst, const float* src, size_t count, float& peak, float& sumSquares);
+
+// dst = src * gain while measuring dst, vectorized
+void scaleMeasured(float* dst, const float* src, size_t count, float gain, float& peak, float& sumSquares);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Input event every source decodes its own packet format into
+struct MidiEvent {
+    enum class Type : uint8_t {
+        NoteOn,
+        NoteOff,
+        PadOn,
+        PadOff,
+        PitchBend,
+    };
+
+    Type type;
+    uint8_t index; // key, or pad 0..cfg::NUM_PERC-1
+    uint8_t value; // velocity, or the pitch bend MSB with 64 at rest
+};
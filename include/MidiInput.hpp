@@ -0,0 +1,105 @@
+#pragma once
+
+#include "MidiEvent.hpp"
+#include "MidiLog.hpp"
+#include "USB.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct _snd_seq;
+struct _snd_rawmidi;
+
+struct InputConfig {
+    std::string capturePath; // USB only, see MidiLogWriter
+    bool replayFast = false;
+    MidiLogPlayer::wait_t replayClock; // paces replay instead of the wall clock when set
+};
+
+// Decodes one MIDI channel message. Notes on the drum channel, or on any channel when
+// pads is set, become pad events. Returns false for anything the engine does not use.
+bool decodeMidiMessage(uint8_t status, uint8_t data1, uint8_t data2, bool pads, MidiEvent& event);
+
+// Source of input events, read on a thread of its own
+class MidiInput {
+public:
+    using callback_t = std::function<void(const MidiEvent* events, size_t count)>;
+
+    virtual ~MidiInput() = default;
+
+    // Blocks reading the source, handing over everything decoded from one read at once
+    virtual void run(callback_t callback) = 0;
+    virtual const char* name() const = 0;
+
+    // "usb:<device>", "seq[:<client>:<port>]", "rawmidi[:<device>]" or "replay:<path>"
+    static std::unique_ptr<MidiInput> create(std::string_view spec, const InputConfig& config);
+
+protected:
+    std::vector<MidiEvent> events_;
+};
+
+// Raw USB-MIDI bulk packets read through usbdevfs, with the kernel driver detached
+class UsbMidiInput : public MidiInput {
+public:
+    UsbMidiInput(const std::string& device, const std::string& capturePath);
+
+    void run(callback_t callback) override;
+    const char* name() const override { return "usb"; }
+
+    // Appends the events in a packet of 4 byte USB-MIDI event groups
+    static void decodePacket(const uint8_t* data, size_t count, std::vector<MidiEvent>& events);
+
+private:
+    USB usb_;
+    std::unique_ptr<MidiLogWriter> capture_;
+};
+
+// Replays a log written by UsbMidiInput's capture
+class ReplayMidiInput : public MidiInput {
+public:
+    ReplayMidiInput(const std::string& path, bool realtime, MidiLogPlayer::wait_t clock = {});
+
+    void run(callback_t callback) override;
+    const char* name() const override { return "replay"; }
+
+private:
+    MidiLogPlayer player_;
+    bool realtime_;
+    MidiLogPlayer::wait_t clock_;
+};
+
+// ALSA sequencer client with one input port, optionally connected to a source port on start
+class SeqMidiInput : public MidiInput {
+public:
+    explicit SeqMidiInput(const std::string& source);
+    ~SeqMidiInput() override;
+
+    void run(callback_t callback) override;
+    const char* name() const override { return "seq"; }
+
+private:
+    _snd_seq* seq_;
+};
+
+// ALSA rawmidi device, parsed as a MIDI byte stream
+class RawMidiInput : public MidiInput {
+public:
+    explicit RawMidiInput(const std::string& device);
+    ~RawMidiInput() override;
+
+    void run(callback_t callback) override;
+    const char* name() const override { return "rawmidi"; }
+
+private:
+    void parse(uint8_t byte);
+
+    _snd_rawmidi* rawmidi_;
+    uint8_t status_; // running status, 0 while none or inside SysEx
+    uint8_t data_[2];
+    size_t have_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "USB.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Compact binary log of the raw packets USB::start delivers. After an 8 byte magic
+// each packet is a LEB128 nanosecond delta from the previous one, the endpoint
+// address, the byte count and the bytes themselves.
+class MidiLogWriter {
+public:
+    explicit MidiLogWriter(const std::string& path);
+    ~MidiLogWriter();
+
+    MidiLogWriter(const MidiLogWriter&) = delete;
+    MidiLogWriter& operator=(const MidiLogWriter&) = delete;
+
+    // Called from the thread that reads the device, stamps the packet with the current time.
+    // Packets are buffered in memory and only reach the file once the buffer fills, or at close.
+    void write(uint8_t address, const uint8_t* data, uint8_t count);
+
+    uint64_t packets() const { return packets_; }
+
+private:
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    std::chrono::steady_clock::time_point last_;
+    uint64_t packets_;
+};
+
+// Feeds a log back through the same callback USB::start uses
+class MidiLogPlayer {
+public:
+    // Called with each packet's offset from the start of the log, returns once that time has come
+    using wait_t = std::function<void(std::chrono::nanoseconds offset)>;
+
+    explicit MidiLogPlayer(const std::string& path);
+
+    // With realtime each packet waits for its original offset from the start,
+    // otherwise they are delivered back to back. Returns once the log is exhausted.
+    void run(USB::callback_t callback, bool realtime);
+
+    // Paced by wait instead of the wall clock, e.g. by an offline render
+    void runPaced(USB::callback_t callback, const wait_t& wait);
+
+private:
+    uint64_t play(const USB::callback_t& callback, const wait_t& wait);
+
+    std::string data_;
+};
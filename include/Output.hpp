@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <portaudio.h>
+#include <sndfile.h>
+
+struct _snd_pcm;
+
+struct StreamConfig {
+    float sampleRate = cfg::DEFAULT_OUTPUT_SAMPLE_RATE;
+    unsigned long frames = cfg::DEFAULT_OUTPUT_FRAMES;
+    bool offline = false; // null and wav only: no timer thread, blocks are pulled with step()
+};
+
+// Audio output backend, pulls interleaved stereo float blocks from the engine
+class Output {
+public:
+    using callback_t = std::function<void(float* out, unsigned long frames)>;
+    using thread_init_t = std::function<void()>;
+
+    explicit Output(const StreamConfig& config) : config_(config), xruns_(0), failed_(false) {}
+    virtual ~Output() = default;
+
+    // threadInit runs once on the rendering thread before the first block
+    virtual void start(callback_t callback, thread_init_t threadInit = {}) = 0;
+    virtual void stop() = 0;
+    virtual const char* name() const = 0;
+
+    // Buffer size actually granted by the device may differ from the one requested
+    const StreamConfig& config() const { return config_; }
+    uint64_t xruns() const { return xruns_.load(); }
+
+    // Set once the stream has died for good (e.g. the device was unplugged), the callback no longer runs
+    bool failed() const { return failed_.load(); }
+
+    // "portaudio", "alsa[:device]", "null" or "wav:<path>"
+    static std::unique_ptr<Output> create(std::string_view spec, const StreamConfig& config);
+
+protected:
+    StreamConfig config_;
+    std::atomic<uint64_t> xruns_;
+    std::atomic<bool> failed_;
+};
+
+class PortAudioOutput : public Output {
+public:
+    explicit PortAudioOutput(const StreamConfig& config);
+    ~PortAudioOutput() override;
+
+    void start(callback_t callback, thread_init_t threadInit) override;
+    void stop() override;
+    const char* name() const override { return "portaudio"; }
+
+private:
+    static int paCallback(const void* input, void* output,
+                          unsigned long framesPerBuffer,
+                          const PaStreamCallbackTimeInfo* timeInfo,
+                          PaStreamCallbackFlags statusFlags,
+                          void* userData);
+
+    callback_t callback_;
+    thread_init_t threadInit_;
+    bool threadStarted_;
+    PaStream* stream_;
+};
+
+// Direct ALSA playback writing straight into the mmap'd ring buffer one period at a time
+class AlsaOutput : public Output {
+public:
+    AlsaOutput(const std::string& device, const StreamConfig& config);
+    ~AlsaOutput() override;
+
+    void start(callback_t callback, thread_init_t threadInit) override;
+    void stop() override;
+    const char* name() const override { return "alsa"; }
+
+private:
+    enum class Format { Float, S32, S16 };
+
+    void run();
+    bool recover(int err, const char* what); // false once the stream is beyond recovery
+
+    callback_t callback_;
+    thread_init_t threadInit_;
+    _snd_pcm* pcm_;
+    Format format_;
+    std::vector<float> buffer_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+};
+
+// Renders on a timer at the output rate and discards the result
+class NullOutput : public Output {
+public:
+    explicit NullOutput(const StreamConfig& config);
+    ~NullOutput() override;
+
+    void start(callback_t callback, thread_init_t threadInit) override;
+    void stop() override;
+    const char* name() const override { return "null"; }
+
+    // Offline only, renders and consumes one block on the calling thread
+    void step();
+
+protected:
+    virtual void consume(const float* data, unsigned long frames);
+
+private:
+    void run();
+
+    callback_t callback_;
+    thread_init_t threadInit_;
+    std::vector<float> buffer_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+};
+
+// Timer-driven like NullOutput, but writes every block to a WAV file
+class WavOutput : public NullOutput {
+public:
+    WavOutput(const std::string& path, const StreamConfig& config);
+    ~WavOutput() override;
+
+    const char* name() const override { return "wav"; }
+
+protected:
+    void consume(const float* data, unsigned long frames) override;
+
+private:
+    SNDFILE* file_;
+};
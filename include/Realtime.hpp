@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+struct RealtimeConfig {
+    bool enabled = false;
+    int audioCpu = -1; // -1 leaves the thread unpinned
+    int inputCpu = -1;
+};
+
+// Outcome of configureRealtimeThread as errno values, 0 where the step worked
+struct RealtimeStatus {
+    int schedError = 0;
+    int affinityError = 0;
+};
+
+// SCHED_FIFO at priority and, if cpu >= 0, pinned to that core, for the calling thread.
+// Prints nothing, so it is safe on the audio thread; the result is reported separately.
+RealtimeStatus configureRealtimeThread(int priority, int cpu);
+
+// The rest report why they failed (usually missing privileges) and return false,
+// the caller is expected to carry on without it
+
+bool reportRealtimeThread(const char* name, int priority, int cpu, const RealtimeStatus& status);
+
+// Locks future allocations too, unless RLIMIT_MEMLOCK is finite: then a later sample load
+// past the limit would fail outright, so only what is mapped now is locked
+bool lockAllMemory();
+
+// Touches every page so the first real access does not fault
+void prefaultMemory(const void* data, size_t bytes);
+void prefaultStack();
+
+// Flush-to-zero and denormals-are-zero for the calling thread
+void enableDenormalFlush();
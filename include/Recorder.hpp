@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sndfile.h>
+
+// Captures the master output to disk. The audio thread only copies blocks into a
+// preallocated single-producer ring; a writer thread drains it to libsndfile.
+class Recorder {
+public:
+    explicit Recorder(float sampleRate);
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Format follows the extension: .flac is 24-bit FLAC, anything else float WAV
+    bool start(const std::string& path);
+    void stop();
+    bool recording() const { return armed_.load(std::memory_order_relaxed); }
+
+    // Audio thread only, wait-free
+    void push(const float* data, unsigned long frames);
+
+    // Faults the ring in ahead of time for realtime mode
+    void prefault() const;
+
+    // Frames dropped because the writer fell behind
+    uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    size_t drain();
+
+    const float sampleRate_;
+    std::vector<float> ring_;
+    const size_t mask_;
+
+    std::atomic<size_t> writePos_;
+    std::atomic<size_t> readPos_;
+    std::atomic<uint64_t> overruns_;
+    std::atomic<bool> armed_;
+
+    SNDFILE* file_;
+    std::string path_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "SampleData.hpp"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+// Decoded samples keyed by file content and decode parameters, shared by every
+// slot that loads the same data. Entries nothing else references any more are
+// kept for quick reloads and evicted least recently used first over the budget.
+class SampleCache {
+public:
+    explicit SampleCache(size_t budgetBytes);
+
+    SampleCache(const SampleCache&) = delete;
+    SampleCache& operator=(const SampleCache&) = delete;
+
+    std::shared_ptr<const SampleData> load(const char* path, SampleStorage storage, bool& reused);
+
+    void setBudget(size_t budgetBytes);
+    size_t budgetBytes() const;
+    size_t residentBytes() const; // may exceed the budget while slots or voices hold the data
+
+private:
+    using Key = std::tuple<uint64_t, uint64_t, SampleStorage>; // content hash, size, storage
+
+    struct Entry {
+        std::shared_ptr<const SampleData> data;
+        size_t bytes;
+        std::list<Key>::iterator lru;
+    };
+
+    std::map<Key, Entry> entries_;
+    std::list<Key> lru_; // most recently used first
+    size_t budget_;
+    size_t resident_;
+    mutable std::mutex mutex_;
+
+    void evict();
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// Width the decoded frames are kept at in memory
+enum class SampleFormat : uint8_t {
+    Float32,
+    Int16,
+    Int24, // packed little-endian, 3 bytes per frame
+};
+
+// How loaded files are stored: always as float, or at the file's own integer width
+enum class SampleStorage : uint8_t {
+    Float,
+    Native,
+};
+
+// Immutable mono or interleaved stereo sample data shared between the loader and the audio thread
+struct SampleData {
+    SampleFormat format = SampleFormat::Float32;
+    int rate = 0;
+    int channels = 1;
+    size_t frames = 0;
+
+    std::vector<float> f32;
+    std::vector<int16_t> i16;
+    std::vector<uint8_t> i24;
+
+    // Band-limited copies at half the rate of the previous one, built at load time.
+    // levels[i] holds every 2^(i + 1)-th frame of the original, filtered.
+    std::vector<SampleData> levels;
+
+    bool empty() const { return frames == 0; }
+    size_t bytes() const; // including levels
+
+    // Level to read for a given step through this data, halving step for every level down,
+    // so that high notes keep stepping through memory roughly one frame at a time
+    const SampleData& levelFor(float& step) const;
+
+    // Converts frames [first, first + count) to interleaved float into dst
+    void decode(size_t first, size_t count, float* dst) const;
+
+    static std::shared_ptr<const SampleData> load(const char* path, SampleStorage storage);
+};
+
+const char* sampleFormatName(SampleFormat format);
+
+// Vectorized integer to float conversion, count is in samples
+void decodeInt16(const int16_t* src, size_t count, float* dst);
+void decodeInt24(const uint8_t* src, size_t count, float* dst);
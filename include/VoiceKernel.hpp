@@ -0,0 +1,27 @@
+#pragma once
+
+#include "SampleData.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+enum class Interpolation : uint8_t {
+    Linear,
+    Sinc, // polyphase windowed sinc, cfg::SINC_TAPS taps
+};
+
+const char* interpolationName(Interpolation interp);
+
+// Mixes frames of one voice into an interleaved stereo buffer, stepping the read
+// position from stepFrom to stepTo over the block. Returns false once the sample ends.
+using kernel_t = bool (*)(const SampleData& sample, double& pos, float stepFrom, float stepTo,
+                          float gain, float* mix, size_t frames, float* scratch);
+
+// Kernels specialized for one interpolation, channel count and storage format.
+// steady assumes stepFrom == stepTo, modulated ramps between them.
+struct VoiceKernel {
+    kernel_t steady;
+    kernel_t modulated;
+};
+
+const VoiceKernel& selectVoiceKernel(Interpolation interp, const SampleData& sample);
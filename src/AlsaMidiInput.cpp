@@ -0,0 +1,150 @@
+#include "MidiInput.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+
+#include <alsa/asoundlib.h>
+
+namespace {
+
+void check(int err, const char* what) {
+    if (err < 0) throw std::runtime_error(std::string(what) + ": " + snd_strerror(err));
+}
+
+// Sequencer events are already parsed, so they are turned back into the channel message they came from
+void decodeSeqEvent(const snd_seq_event_t& ev, std::vector<MidiEvent>& events) {
+    MidiEvent event;
+    bool decoded = false;
+
+    switch (ev.type) {
+        case SND_SEQ_EVENT_NOTEON:
+            decoded = decodeMidiMessage(0x90 | (ev.data.note.channel & 0x0f), ev.data.note.note, ev.data.note.velocity, false, event);
+            break;
+        case SND_SEQ_EVENT_NOTEOFF:
+            decoded = decodeMidiMessage(0x80 | (ev.data.note.channel & 0x0f), ev.data.note.note, ev.data.note.velocity, false, event);
+            break;
+        case SND_SEQ_EVENT_PITCHBEND: {
+            uint8_t msb = static_cast<uint8_t>(std::clamp((ev.data.control.value + 8192) >> 7, 0, 127));
+            decoded = decodeMidiMessage(0xe0 | (ev.data.control.channel & 0x0f), 0, msb, false, event);
+        } break;
+        default:
+            break;
+    }
+
+    if (decoded) events.push_back(event);
+}
+
+} // namespace
+
+SeqMidiInput::SeqMidiInput(const std::string& source)
+    : seq_(nullptr)
+{
+    check(snd_seq_open(&seq_, "default", SND_SEQ_OPEN_INPUT, 0), "snd_seq_open");
+
+    try {
+        check(snd_seq_set_client_name(seq_, "midi-sampler"), "snd_seq_set_client_name");
+
+        int port = snd_seq_create_simple_port(seq_, "input",
+                                              SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                              SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+        check(port, "snd_seq_create_simple_port");
+
+        // Without a source the port waits to be connected from outside, e.g. with aconnect
+        if (!source.empty()) {
+            snd_seq_addr_t addr;
+            check(snd_seq_parse_address(seq_, &addr, source.c_str()), "snd_seq_parse_address");
+            check(snd_seq_connect_from(seq_, port, addr.client, addr.port), "snd_seq_connect_from");
+        }
+
+        std::printf("MIDI input: sequencer port %d:%d\n", snd_seq_client_id(seq_), port);
+    } catch (...) {
+        snd_seq_close(seq_);
+        throw;
+    }
+}
+
+SeqMidiInput::~SeqMidiInput() {
+    snd_seq_close(seq_);
+}
+
+void SeqMidiInput::run(callback_t callback) {
+    while (true) {
+        events_.clear();
+
+        // Blocks for the first event, then takes whatever else already arrived
+        do {
+            snd_seq_event_t* ev = nullptr;
+            int err = snd_seq_event_input(seq_, &ev);
+
+            if (err == -ENOSPC) {
+                std::fprintf(stderr, "MIDI input: sequencer queue overran, events were lost\n");
+            } else if (err == -EAGAIN || err == -EINTR) {
+                continue;
+            } else if (err < 0) {
+                std::fprintf(stderr, "MIDI input: snd_seq_event_input: %s\n", snd_strerror(err));
+                return;
+            } else if (ev) {
+                decodeSeqEvent(*ev, events_);
+            }
+        } while (snd_seq_event_input_pending(seq_, 0) > 0);
+
+        if (!events_.empty()) callback(events_.data(), events_.size());
+    }
+}
+
+RawMidiInput::RawMidiInput(const std::string& device)
+    : rawmidi_(nullptr),
+      status_(0),
+      data_{},
+      have_(0)
+{
+    check(snd_rawmidi_open(&rawmidi_, nullptr, device.c_str(), 0), "snd_rawmidi_open");
+    std::printf("MIDI input: rawmidi %s\n", device.c_str());
+}
+
+RawMidiInput::~RawMidiInput() {
+    snd_rawmidi_close(rawmidi_);
+}
+
+void RawMidiInput::parse(uint8_t byte) {
+    // Real-time messages may appear anywhere, even inside another message
+    if (byte >= 0xf8) return;
+
+    if (byte & 0x80) {
+        // System common and SysEx clear the running status
+        status_ = byte < 0xf0 ? byte : 0;
+        have_ = 0;
+        return;
+    }
+
+    if (!status_) return;
+
+    data_[have_++] = byte;
+
+    uint8_t type = status_ & 0xf0;
+    size_t needed = (type == 0xc0 || type == 0xd0) ? 1 : 2;
+    if (have_ < needed) return;
+    have_ = 0;
+
+    MidiEvent event;
+    if (decodeMidiMessage(status_, data_[0], data_[1], false, event)) events_.push_back(event);
+}
+
+void RawMidiInput::run(callback_t callback) {
+    uint8_t buffer[256];
+
+    while (true) {
+        long read = snd_rawmidi_read(rawmidi_, buffer, sizeof(buffer));
+        if (read == -EAGAIN || read == -EINTR) continue;
+        if (read < 0) {
+            std::fprintf(stderr, "MIDI input: snd_rawmidi_read: %s\n", snd_strerror(static_cast<int>(read)));
+            return;
+        }
+
+        events_.clear();
+        for (long i = 0; i < read; ++i) parse(buffer[i]);
+        if (!events_.empty()) callback(events_.data(), events_.size());
+    }
+}
@@ -0,0 +1,179 @@
+#include "Output.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+#include <alsa/asoundlib.h>
+
+namespace {
+
+constexpr unsigned int ALSA_PERIODS = 2;
+
+void check(int err, const char* what) {
+    if (err < 0) throw std::runtime_error(std::string(what) + ": " + snd_strerror(err));
+}
+
+template <typename T>
+void convert(const float* src, T* dst, unsigned long samples, float scale) {
+    for (unsigned long i = 0; i < samples; ++i) {
+        dst[i] = static_cast<T>(std::clamp(src[i], -1.f, 1.f) * scale);
+    }
+}
+
+} // namespace
+
+AlsaOutput::AlsaOutput(const std::string& device, const StreamConfig& config)
+    : Output(config),
+      pcm_(nullptr),
+      format_(Format::Float),
+      running_(false)
+{
+    check(snd_pcm_open(&pcm_, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0), "snd_pcm_open");
+
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_sw_params_t* sw = nullptr;
+
+    try {
+        check(snd_pcm_hw_params_malloc(&hw), "snd_pcm_hw_params_malloc");
+        check(snd_pcm_hw_params_any(pcm_, hw), "snd_pcm_hw_params_any");
+        check(snd_pcm_hw_params_set_access(pcm_, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED), "mmap access");
+
+        // Hardware devices rarely take float directly, fall back to the widest integer format
+        if (snd_pcm_hw_params_set_format(pcm_, hw, SND_PCM_FORMAT_FLOAT_LE) == 0) format_ = Format::Float;
+        else if (snd_pcm_hw_params_set_format(pcm_, hw, SND_PCM_FORMAT_S32_LE) == 0) format_ = Format::S32;
+        else {
+            check(snd_pcm_hw_params_set_format(pcm_, hw, SND_PCM_FORMAT_S16_LE), "sample format");
+            format_ = Format::S16;
+        }
+
+        check(snd_pcm_hw_params_set_channels(pcm_, hw, 2), "channels");
+
+        unsigned int rate = static_cast<unsigned int>(config_.sampleRate);
+        check(snd_pcm_hw_params_set_rate_near(pcm_, hw, &rate, nullptr), "sample rate");
+        if (rate != static_cast<unsigned int>(config_.sampleRate)) {
+            throw std::runtime_error("ALSA device does not support " +
+                                     std::to_string(static_cast<int>(config_.sampleRate)) + " Hz");
+        }
+
+        snd_pcm_uframes_t period = config_.frames;
+        check(snd_pcm_hw_params_set_period_size_near(pcm_, hw, &period, nullptr), "period size");
+
+        unsigned int periods = ALSA_PERIODS;
+        check(snd_pcm_hw_params_set_periods_near(pcm_, hw, &periods, nullptr), "periods");
+
+        check(snd_pcm_hw_params(pcm_, hw), "snd_pcm_hw_params");
+        config_.frames = period;
+
+        // Wake up once a whole period is free. mmap commits never trigger the start
+        // threshold, so run() starts the stream itself once the ring is full.
+        check(snd_pcm_sw_params_malloc(&sw), "snd_pcm_sw_params_malloc");
+        check(snd_pcm_sw_params_current(pcm_, sw), "snd_pcm_sw_params_current");
+        check(snd_pcm_sw_params_set_avail_min(pcm_, sw, period), "avail min");
+        check(snd_pcm_sw_params(pcm_, sw), "snd_pcm_sw_params");
+
+        check(snd_pcm_prepare(pcm_), "snd_pcm_prepare");
+    } catch (...) {
+        if (hw) snd_pcm_hw_params_free(hw);
+        if (sw) snd_pcm_sw_params_free(sw);
+        snd_pcm_close(pcm_);
+        throw;
+    }
+
+    snd_pcm_hw_params_free(hw);
+    snd_pcm_sw_params_free(sw);
+
+    buffer_.resize(config_.frames * 2, 0.f);
+}
+
+AlsaOutput::~AlsaOutput() {
+    stop();
+    snd_pcm_close(pcm_);
+}
+
+void AlsaOutput::start(callback_t callback, thread_init_t threadInit) {
+    callback_ = std::move(callback);
+    threadInit_ = std::move(threadInit);
+    running_.store(true);
+    thread_ = std::thread([this]() { run(); });
+}
+
+void AlsaOutput::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+    snd_pcm_drop(pcm_);
+}
+
+bool AlsaOutput::recover(int err, const char* what) {
+    ++xruns_;
+
+    int result = snd_pcm_recover(pcm_, err, 1);
+    if (result < 0) {
+        // The thread ends here, printing is fine. The failed flag tells Audio and the tuner.
+        std::fprintf(stderr, "ALSA output: %s failed for good: %s\n", what, snd_strerror(result));
+        failed_.store(true);
+        return false;
+    }
+    return true;
+}
+
+void AlsaOutput::run() {
+    if (threadInit_) threadInit_();
+
+    while (running_.load() && !failed_.load()) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(pcm_);
+        if (avail < 0) {
+            if (!recover(static_cast<int>(avail), "snd_pcm_avail_update")) break;
+            continue;
+        }
+
+        if (static_cast<snd_pcm_uframes_t>(avail) < config_.frames) {
+            // No room for another period: the ring is full, which after prepare or
+            // a recover is the moment to start playback
+            if (snd_pcm_state(pcm_) == SND_PCM_STATE_PREPARED) {
+                int err = snd_pcm_start(pcm_);
+                if (err < 0 && !recover(err, "snd_pcm_start")) break;
+                continue;
+            }
+
+            int err = snd_pcm_wait(pcm_, 100);
+            if (err < 0 && !recover(err, "snd_pcm_wait")) break;
+            continue;
+        }
+
+        callback_(buffer_.data(), config_.frames);
+
+        // The ring may wrap inside a period, in which case it takes two mmap transfers
+        snd_pcm_uframes_t written = 0;
+        while (written < config_.frames) {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t frames = config_.frames - written;
+
+            int err = snd_pcm_mmap_begin(pcm_, &areas, &offset, &frames);
+            if (err < 0) {
+                recover(err, "snd_pcm_mmap_begin");
+                break;
+            }
+
+            uint8_t* dst = static_cast<uint8_t*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+            const float* src = buffer_.data() + written * 2;
+
+            switch (format_) {
+                case Format::Float: convert(src, reinterpret_cast<float*>(dst), frames * 2, 1.f); break;
+                case Format::S32: convert(src, reinterpret_cast<int32_t*>(dst), frames * 2, 2147483520.f); break;
+                case Format::S16: convert(src, reinterpret_cast<int16_t*>(dst), frames * 2, 32767.f); break;
+            }
+
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm_, offset, frames);
+            if (committed < 0 || static_cast<snd_pcm_uframes_t>(committed) != frames) {
+                recover(committed < 0 ? static_cast<int>(committed) : -EPIPE, "snd_pcm_mmap_commit");
+                break;
+            }
+
+            written += frames;
+        }
+    }
+}
@@ -5,75 +5,171 @@
 #include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <chrono>
+#include <thread>
 
-Audio::Audio()
-    : activeVoices_(),
+namespace {
+
+// How long setOutput waits for the rendering thread to report its realtime setup
+constexpr auto THREAD_START_TIMEOUT = std::chrono::seconds(1);
+
+void prefaultSample(const SampleData& sample) {
+    prefaultMemory(sample.f32.data(), sample.f32.size() * sizeof(float));
+    prefaultMemory(sample.i16.data(), sample.i16.size() * sizeof(int16_t));
+    prefaultMemory(sample.i24.data(), sample.i24.size());
+    for (const auto& level : sample.levels) prefaultSample(level);
+}
+
+// Picks the steady kernel while the pitch bend holds still and ramps when it moved
+template <typename V>
+void renderVoice(V& v, float bend, float* mix, size_t frames, float* scratch) {
+    kernel_t kernel = v.bend == bend ? v.kernel->steady : v.kernel->modulated;
+    v.alive = kernel(*v.level, v.pos, v.increment * v.bend, v.increment * bend,
+                     v.velocity, mix, frames, scratch);
+    v.bend = bend;
+}
+
+} // namespace
+
+Audio::Audio(std::unique_ptr<Output> output, float sampleRate, const RealtimeConfig& realtime,
+             uint32_t effectBypass)
+    : cache_(cfg::SAMPLE_CACHE_MB << 20),
+      activeVoices_(),
       fftSmoothed_(cfg::FFT_SIZE / 2, 0.f),
       hannWindow_(cfg::FFT_SIZE, 0.f),
       keys_({ 0 }),
       pitch_(64),
-      stream_(nullptr)
+      storage_(SampleStorage::Float),
+      mixBuffer_(cfg::MIX_FRAMES * 2, 0.f),
+      groupBuffer_(cfg::MIX_FRAMES * 2, 0.f),
+      decodeBuffer_(cfg::DECODE_FRAMES, 0.f),
+      sampleRate_(sampleRate),
+      realtime_(realtime),
+      effects_(sampleRate, effectBypass),
+      peakLoad_(0.f),
+      threadReady_(false),
+      recorder_(sampleRate),
+      replacedFailed_(false)
 {
-    PaError err = Pa_Initialize();
-    if (err != paNoError) {
-        throw std::runtime_error("PortAudio init failed");
+    initHannWindow();
+
+    // Sized for the largest period the tuner or --frames can ask for, the audio thread then only
+    // resizes within this capacity. Written once so its pages are touched before playback.
+    size_t snapshotFrames = std::max<size_t>(cfg::TUNE_MAX_FRAMES, output ? output->config().frames : 0);
+    audioSnapshot_.assign(snapshotFrames * 2, 0.f);
+    audioSnapshot_.clear();
+
+    if (realtime_.enabled) {
+        lockAllMemory();
+        prefaultMemory(mixBuffer_.data(), mixBuffer_.size() * sizeof(float));
+        prefaultMemory(groupBuffer_.data(), groupBuffer_.size() * sizeof(float));
+        prefaultMemory(decodeBuffer_.data(), decodeBuffer_.size() * sizeof(float));
+        prefaultMemory(audioSnapshot_.data(), audioSnapshot_.capacity() * sizeof(float));
+        recorder_.prefault();
     }
 
-    initHannWindow();
+    setOutput(std::move(output));
+}
 
-    PaDeviceIndex device = paNoDevice;
+Audio::~Audio() {
+    setOutput(nullptr);
+    recorder_.stop();
+}
 
-    {
-        int numDevices = Pa_GetDeviceCount();
-        for (int i = 0; i < numDevices; i++) {
-            const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
-            if (std::string("pipewire") == info->name) {
-                device = i;
-                break;
-            }
+void Audio::setOutput(std::unique_ptr<Output> output) {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    replacedFailed_ = false;
+    startOutput(std::move(output));
+}
+
+bool Audio::checkOutput() {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    if (!output_ || !output_->failed()) return true;
+
+    std::fprintf(stderr, "Audio output %s failed, carrying on silently with the null output\n", output_->name());
+    StreamConfig config = output_->config();
+    config.offline = false;
+    replacedFailed_ = true;
+    startOutput(std::make_unique<NullOutput>(config));
+    return false;
+}
+
+void Audio::startOutput(std::unique_ptr<Output> output) {
+    // The old stream is closed first, some devices can only be opened once
+    if (output_) output_->stop();
+    output_ = std::move(output);
+    if (!output_) return;
+
+    Output::callback_t callback = [this](float* out, unsigned long frames) {
+        auto begin = std::chrono::steady_clock::now();
+        processAudio(out, frames);
+        std::chrono::duration<float> took = std::chrono::steady_clock::now() - begin;
+
+        float load = took.count() * sampleRate_ / frames;
+        float peak = peakLoad_.load(std::memory_order_relaxed);
+        while (load > peak && !peakLoad_.compare_exchange_weak(peak, load, std::memory_order_relaxed)) {}
+    };
+
+    // The rendering thread belongs to the backend, so it sets itself up before its first
+    // block and leaves the report to this thread
+    threadReady_.store(false);
+    Output::thread_init_t threadInit = [this]() {
+        // Always, since the recursive filters in the effects decay into denormals
+        enableDenormalFlush();
+
+        if (realtime_.enabled) {
+            threadStatus_ = configureRealtimeThread(cfg::RT_AUDIO_PRIORITY, realtime_.audioCpu);
+            prefaultStack();
         }
+        threadReady_.store(true, std::memory_order_release);
+    };
+
+    // A stream that fails to start is dropped rather than left half open
+    try {
+        output_->start(std::move(callback), std::move(threadInit));
+    } catch (...) {
+        output_.reset();
+        throw;
     }
 
-    if (device == paNoDevice) device = Pa_GetDefaultOutputDevice();
-
-    if (device == paNoDevice) throw std::runtime_error("No default output device");
-
-    const PaDeviceInfo* devInfo = Pa_GetDeviceInfo(device);
-    PaStreamParameters outParams;
-    outParams.device = device;
-    outParams.channelCount = 2;
-    outParams.sampleFormat = paFloat32;
-    outParams.suggestedLatency = devInfo->defaultLowOutputLatency;
-    outParams.hostApiSpecificStreamInfo = nullptr;
-
-    err = Pa_OpenStream(&stream_,
-                        nullptr,
-                        &outParams,
-                        cfg::OUTPUT_SAMPLE_RATE,
-                        cfg::PA_FRAMES,
-                        paNoFlag,
-                        &Audio::paCallback,
-                        this);
-    if (err != paNoError) {
-        Pa_Terminate();
-        throw std::runtime_error("Pa_OpenStream failed");
-    }
+    std::printf("Audio output: %s, %.0f Hz, %lu frames\n",
+                output_->name(), sampleRate_, output_->config().frames);
 
-    err = Pa_StartStream(stream_);
-    if (err != paNoError) {
-        Pa_CloseStream(stream_);
-        Pa_Terminate();
-        throw std::runtime_error("Pa_StartStream failed");
+    if (realtime_.enabled) {
+        auto deadline = std::chrono::steady_clock::now() + THREAD_START_TIMEOUT;
+        while (!threadReady_.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (threadReady_.load(std::memory_order_acquire)) {
+            reportRealtimeThread("audio", cfg::RT_AUDIO_PRIORITY, realtime_.audioCpu, threadStatus_);
+        } else {
+            std::fprintf(stderr, "Realtime: audio thread has not started yet, its scheduling is unconfirmed\n");
+        }
     }
 }
 
-Audio::~Audio() {
-    if (stream_) {
-        Pa_StopStream(stream_);
-        Pa_CloseStream(stream_);
-        stream_ = nullptr;
-    }
-    Pa_Terminate();
+unsigned long Audio::outputFrames() const {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    return output_ ? output_->config().frames : 0;
+}
+
+uint64_t Audio::outputXruns() const {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    return output_ ? output_->xruns() : 0;
+}
+
+bool Audio::outputFailed() const {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    return replacedFailed_ || (output_ && output_->failed());
+}
+
+float Audio::takePeakLoad() {
+    return peakLoad_.exchange(0.f);
+}
+
+MeterLevel Audio::takeMeter(size_t meter) {
+    return meter < NUM_METERS ? meters_[meter].take() : MeterLevel{ 0.f, 0.f };
 }
 
 void Audio::initHannWindow() {
@@ -82,6 +178,11 @@ void Audio::initHannWindow() {
     }
 }
 
+std::shared_ptr<const SampleData> Audio::Sample::get() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return data;
+}
+
 float Audio::frequencyFromMidi(int key) const {
     return 440.f * std::pow(2.f, (key - 69) / 12.f);
 }
@@ -92,83 +193,110 @@ float Audio::pitchBendFactor() const {
     return std::pow(2.f, bend * semitoneRange / 12.f / 63.f);
 }
 
-void Audio::noteOn(uint8_t key, uint8_t velocity) {
-    if (key >= cfg::NUM_KEYS) return;
-    
-    std::lock_guard<std::mutex> lockVoice(voiceMutex_);
-    float inc = static_cast<float>(pianoSample_.rate) / cfg::OUTPUT_SAMPLE_RATE *
-                (frequencyFromMidi(key) / frequencyFromMidi(60));
-    
-    Voice v;
+bool Audio::makeVoice(uint8_t key, uint8_t velocity, Voice& v) {
+    if (key >= cfg::NUM_KEYS) return false;
+
+    keys_[key] = velocity;
+
+    auto sample = pianoSample_.get();
+    if (!sample || sample->empty()) return false;
+
     v.key = static_cast<int>(key);
-    v.pos = 0.f;
-    v.increment = inc;
+    v.increment = static_cast<float>(sample->rate) / sampleRate_ *
+                  (frequencyFromMidi(key) / frequencyFromMidi(60));
+    v.level = &sample->levelFor(v.increment);
+    v.kernel = &selectVoiceKernel(pianoSample_.interpolation.load(), *v.level);
+    v.pos = 0.0;
     v.velocity = (velocity / 127.f);
+    v.bend = pitchBendFactor();
     v.alive = true;
-    activeVoices_.push_back(v);
+    v.sample = std::move(sample);
+    return true;
+}
 
-    {
-        std::lock_guard<std::mutex> lockKeys(pianoSample_.mutex);
-    }
+bool Audio::makePercVoice(uint8_t idx, uint8_t velocity, PercVoice& pv) {
+    if (idx >= cfg::NUM_PERC) return false;
 
-    keys_[key] = velocity;
-}
+    perc_[idx] = velocity;
 
-void Audio::percOn(uint8_t idx, uint8_t velocity) {
-    if (idx >= cfg::NUM_PERC) return;
+    auto sample = percSamples_[idx].get();
+    if (!sample || sample->empty()) return false;
 
-    std::lock_guard<std::mutex> lockVoice(voiceMutex_);
-    float inc = static_cast<float>(percSamples_[idx].rate) / cfg::OUTPUT_SAMPLE_RATE;
-    
-    PercVoice pv;
     pv.idx = idx;
-    pv.pos = 0.f;
-    pv.increment = inc;
+    pv.increment = static_cast<float>(sample->rate) / sampleRate_;
+    pv.level = &sample->levelFor(pv.increment);
+    pv.kernel = &selectVoiceKernel(percSamples_[idx].interpolation.load(), *pv.level);
+    pv.pos = 0.0;
     pv.velocity = (velocity / 127.f);
+    pv.bend = pitchBendFactor();
     pv.alive = true;
+    pv.sample = std::move(sample);
+    return true;
+}
 
-    activePercs_.push_back(pv);
+void Audio::handleEvents(const MidiEvent* events, size_t count) {
+    // Voices are prepared first, so each voice list is locked once for the whole batch
+    std::vector<Voice> voices;
+    std::vector<PercVoice> percs;
+
+    for (size_t i = 0; i < count; ++i) {
+        const MidiEvent& e = events[i];
+
+        switch (e.type) {
+            case MidiEvent::Type::NoteOn: {
+                Voice v;
+                if (makeVoice(e.index, e.value, v)) voices.push_back(std::move(v));
+            } break;
+            case MidiEvent::Type::PadOn: {
+                PercVoice pv;
+                if (makePercVoice(e.index, e.value, pv)) percs.push_back(std::move(pv));
+            } break;
+            case MidiEvent::Type::PitchBend:
+                pitch_.store(e.value);
+                break;
+            case MidiEvent::Type::NoteOff: // samples play out, the key display decays on its own
+            case MidiEvent::Type::PadOff:
+                break;
+        }
+    }
 
-    {
-        std::lock_guard<std::mutex> lockKeys(percSamples_[idx].mutex);
+    if (!voices.empty()) {
+        std::lock_guard<std::mutex> lockVoice(voiceMutex_);
+        for (auto& v : voices) activeVoices_.push_back(std::move(v));
+    }
+
+    if (!percs.empty()) {
+        std::lock_guard<std::mutex> lockPerc(percMutex_);
+        for (auto& pv : percs) activePercs_.push_back(std::move(pv));
     }
-    
-    perc_[idx] = velocity;
 }
 
+void Audio::setSampleStorage(SampleStorage storage) {
+    storage_.store(storage);
+}
+
+void Audio::setPianoInterpolation(Interpolation interp) {
+    pianoSample_.interpolation.store(interp);
+}
 
-void Audio::pitchBend(uint8_t value) {
-    pitch_.store(value);
+void Audio::setPercInterpolation(uint8_t idx, Interpolation interp) {
+    if (idx >= cfg::NUM_PERC) return;
+    percSamples_[idx].interpolation.store(interp);
 }
 
 bool Audio::loadSample(const char* path) {
-    SF_INFO sfinfo{};
-    SNDFILE* sndfile = sf_open(path, SFM_READ, &sfinfo);
-    if (!sndfile) {
-        std::cerr << "Failed to open sample: " << path << "\n";
-        return false;
-    }
+    bool reused;
+    auto data = cache_.load(path, storage_.load(), reused);
+    if (!data) return false;
 
-    pianoSample_.rate = sfinfo.samplerate;
-    pianoSample_.channels = sfinfo.channels;
-    size_t samples = static_cast<size_t>(sfinfo.frames) * sfinfo.channels;
-    std::vector<float> data(samples);
-    sf_read_float(sndfile, data.data(), static_cast<sf_count_t>(samples));
-    sf_close(sndfile);
-
-    if (pianoSample_.channels == 2) {
-        std::vector<float> mono(sfinfo.frames);
-        for (size_t i = 0; i < static_cast<size_t>(sfinfo.frames); ++i) {
-            mono[i] = 0.5f * (data[i * 2] + data[i * 2 + 1]);
-        }
-        data = std::move(mono);
-        pianoSample_.channels = 1;
-    }
+    size_t bytes = data->bytes();
+    SampleFormat format = data->format;
+
+    if (realtime_.enabled) prefaultSample(*data);
 
     {
         std::lock_guard<std::mutex> lock(pianoSample_.mutex);
         pianoSample_.data = std::move(data);
-        pianoSample_.loaded.store(true);
     }
     
     {
@@ -176,131 +304,112 @@ bool Audio::loadSample(const char* path) {
         activeVoices_.clear();
     }
 
-    std::printf("Loaded sample %s in piano\n", path);
+    std::printf("Loaded sample %s in piano (%s, %zu KiB%s), cache %zu of %zu MiB\n", path, sampleFormatName(format),
+                bytes / 1024, reused ? ", shared" : "", cache_.residentBytes() >> 20, cache_.budgetBytes() >> 20);
 
     return true;
 }
 
 bool Audio::loadPercSample(uint8_t idx, const char* path) {
-    SF_INFO sfinfo{};
-    SNDFILE* sndfile = sf_open(path, SFM_READ, &sfinfo);
-    if (!sndfile) {
-        std::cerr << "Failed to open sample: " << path << "\n";
-        return false;
-    }
+    if (idx >= cfg::NUM_PERC) return false;
 
-    percSamples_[idx].rate = sfinfo.samplerate;
-    percSamples_[idx].channels = sfinfo.channels;
-    size_t samples = static_cast<size_t>(sfinfo.frames) * sfinfo.channels;
-    std::vector<float> data(samples);
-    sf_read_float(sndfile, data.data(), static_cast<sf_count_t>(samples));
-    sf_close(sndfile);
-
-    if (percSamples_[idx].channels == 2) {
-        std::vector<float> mono(sfinfo.frames);
-        for (size_t i = 0; i < static_cast<size_t>(sfinfo.frames); ++i) {
-            mono[i] = 0.5f * (data[i * 2] + data[i * 2 + 1]);
-        }
-        data = std::move(mono);
-        percSamples_[idx].channels = 1;
-    }
+    bool reused;
+    auto data = cache_.load(path, storage_.load(), reused);
+    if (!data) return false;
+
+    size_t bytes = data->bytes();
+    SampleFormat format = data->format;
+
+    if (realtime_.enabled) prefaultSample(*data);
 
     {
         std::lock_guard<std::mutex> lock(percSamples_[idx].mutex);
         percSamples_[idx].data = std::move(data);
-        percSamples_[idx].loaded.store(true);
     }
-    
+
+    // Only this pad's voices still play the old sample
     {
-        std::lock_guard<std::mutex> lock(voiceMutex_);
-        activeVoices_.clear();
+        std::lock_guard<std::mutex> lock(percMutex_);
+        activePercs_.erase(std::remove_if(activePercs_.begin(), activePercs_.end(),
+                                          [idx](const PercVoice& pv){ return pv.idx == idx; }),
+                           activePercs_.end());
     }
 
-    std::printf("Loaded sample %s in percussion key %d\n", path, idx);
+    std::printf("Loaded sample %s in percussion key %d (%s, %zu KiB%s), cache %zu of %zu MiB\n", path, idx,
+                sampleFormatName(format), bytes / 1024, reused ? ", shared" : "",
+                cache_.residentBytes() >> 20, cache_.budgetBytes() >> 20);
 
     return true;
 }
 
-int Audio::paCallback(const void* input, void* output,
-                      unsigned long framesPerBuffer,
-                      const PaStreamCallbackTimeInfo* timeInfo,
-                      PaStreamCallbackFlags statusFlags,
-                      void* userData)
-{
-    (void) input;
-    (void) timeInfo;
-    (void) statusFlags;
+void Audio::processAudio(float* outputBuffer, unsigned long framesPerBuffer) {
+    float* out = outputBuffer;
 
-    Audio* self = static_cast<Audio*>(userData);
-    return self->processAudio(output, framesPerBuffer);
-}
+    std::scoped_lock lock(voiceMutex_, percMutex_);
 
-int Audio::processAudio(void* outputBuffer, unsigned long framesPerBuffer) {
-    float* out = reinterpret_cast<float*>(outputBuffer);
+    const float bend = pitchBendFactor();
 
-    // Copy piano sample once
-    std::vector<float> localPiano;
-    {
-        std::lock_guard<std::mutex> lock(pianoSample_.mutex);
-        if (pianoSample_.loaded) localPiano = pianoSample_.data;
-    }
+    // Each group renders into its own buffer and is measured while it is summed into the mix
+    std::array<float, NUM_METERS> peak{}, sumSquares{};
 
-    // Copy percussion samples once
-    std::vector<std::vector<float>> localPerc(cfg::NUM_PERC);
-    for (size_t i = 0; i < cfg::NUM_PERC; ++i) {
-        std::lock_guard<std::mutex> lock(percSamples_[i].mutex);
-        if (percSamples_[i].loaded) localPerc[i] = percSamples_[i].data;
-    }
+    std::array<bool, cfg::NUM_PERC> padActive{};
+    for (const auto& p : activePercs_) padActive[p.idx] = true;
 
-    std::scoped_lock lock(voiceMutex_, percMutex_);
+    for (unsigned long offset = 0; offset < framesPerBuffer; offset += cfg::MIX_FRAMES) {
+        size_t frames = std::min<unsigned long>(framesPerBuffer - offset, cfg::MIX_FRAMES);
+        float* mix = mixBuffer_.data();
+        float* group = groupBuffer_.data();
+        std::fill_n(mix, frames * 2, 0.f);
 
-    for (unsigned long i = 0; i < framesPerBuffer; ++i) {
-        float left = 0.f, right = 0.f;
+        if (!activeVoices_.empty()) {
+            std::fill_n(group, frames * 2, 0.f);
+            for (auto &v : activeVoices_) {
+                if (v.alive) renderVoice(v, bend, group, frames, decodeBuffer_.data());
+            }
+            accumulateMeasured(mix, group, frames * 2, peak[METER_PIANO], sumSquares[METER_PIANO]);
+        }
 
-        for (auto &v : activeVoices_) {
-            if (!v.alive || localPiano.empty()) continue;
+        for (size_t idx = 0; idx < cfg::NUM_PERC; ++idx) {
+            if (!padActive[idx]) continue;
 
-            if (v.pos + 1.f < static_cast<float>(localPiano.size())) {
-                size_t ipos = static_cast<size_t>(v.pos);
-                float frac = v.pos - ipos;
-                float smp = localPiano[ipos] + (localPiano[ipos + 1] - localPiano[ipos]) * frac;
-                left += smp * v.velocity;
-                right += smp * v.velocity;
-                v.pos += v.increment * pitchBendFactor();
-            } else v.alive = false;
+            std::fill_n(group, frames * 2, 0.f);
+            for (auto &p : activePercs_) {
+                if (p.alive && p.idx == static_cast<int>(idx)) renderVoice(p, bend, group, frames, decodeBuffer_.data());
+            }
+            accumulateMeasured(mix, group, frames * 2, peak[METER_PERC + idx], sumSquares[METER_PERC + idx]);
         }
 
-        for (auto &p : activePercs_) {
-            if (!p.alive || localPerc[p.idx].empty()) continue;
-
-            if (p.pos + 1.f < static_cast<float>(localPerc[p.idx].size())) {
-                size_t ipos = static_cast<size_t>(p.pos);
-                float frac = p.pos - ipos;
-                float smp = localPerc[p.idx][ipos] + (localPerc[p.idx][ipos + 1] - localPerc[p.idx][ipos]) * frac;
-                left += smp * p.velocity;
-                right += smp * p.velocity;
-                p.pos += p.increment * pitchBendFactor();
-            } else p.alive = false;
-        }
+        for (size_t k = 0; k < frames * 2; ++k) mix[k] *= cfg::MASTER_GAIN;
+        effects_.process(mix, frames, 0, EffectChain::LIMITER);
 
-        activeVoices_.erase(std::remove_if(activeVoices_.begin(), activeVoices_.end(),
-                                           [](const Voice& vv){ return !vv.alive; }),
-                            activeVoices_.end());
-        activePercs_.erase(std::remove_if(activePercs_.begin(), activePercs_.end(),
-                                          [](const PercVoice& pp){ return !pp.alive; }),
-                           activePercs_.end());
+        // Metered before the limiter, which would otherwise hide every clip
+        scaleMeasured(out, mix, frames * 2, 1.f, peak[METER_MASTER], sumSquares[METER_MASTER]);
+        effects_.process(out, frames, EffectChain::LIMITER);
+        out += frames * 2;
+    }
 
-        *out++ = left * 0.2f;
-        *out++ = right * 0.2f;
+    // Groups are measured before the master gain, scale them so they read at the level going into the effects
+    for (size_t m = 0; m < NUM_METERS; ++m) {
+        float gain = m == METER_MASTER ? 1.f : cfg::MASTER_GAIN;
+        meters_[m].publish(peak[m] * gain, sumSquares[m] * gain * gain, framesPerBuffer * 2);
     }
 
+    activeVoices_.erase(std::remove_if(activeVoices_.begin(), activeVoices_.end(),
+                                       [](const Voice& vv){ return !vv.alive; }),
+                        activeVoices_.end());
+    activePercs_.erase(std::remove_if(activePercs_.begin(), activePercs_.end(),
+                                      [](const PercVoice& pp){ return !pp.alive; }),
+                       activePercs_.end());
+
+    recorder_.push(outputBuffer, framesPerBuffer);
+
     {
         std::lock_guard<std::mutex> snapLock(audioSnapshotMutex_);
-        audioSnapshot_.resize(framesPerBuffer * 2);
-        std::memcpy(audioSnapshot_.data(), outputBuffer, sizeof(float) * framesPerBuffer * 2);
+        // Never past the capacity reserved up front, a larger period keeps only its start
+        size_t samples = std::min<size_t>(framesPerBuffer * 2, audioSnapshot_.capacity());
+        audioSnapshot_.resize(samples);
+        std::memcpy(audioSnapshot_.data(), outputBuffer, sizeof(float) * samples);
     }
-
-    return paContinue;
 }
 
 void Audio::computeSpectrum() {
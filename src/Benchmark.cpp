@@ -0,0 +1,135 @@
+#include "Benchmark.hpp"
+#include "Config.hpp"
+#include "SampleData.hpp"
+#include "VoiceKernel.hpp"
+#include "Effects.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t BENCH_SAMPLE_SECONDS = 10;
+constexpr size_t BENCH_VOICES = 64;
+constexpr size_t BENCH_BLOCKS = 2000;
+constexpr int BENCH_RUNS = 5;
+
+size_t bytesPerFrame(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16: return 2;
+        case SampleFormat::Int24: return 3;
+        default: return 4;
+    }
+}
+
+SampleData makeNoise(SampleFormat format, int rate) {
+    SampleData sample;
+    sample.format = format;
+    sample.rate = rate;
+    sample.frames = BENCH_SAMPLE_SECONDS * rate;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+
+    switch (format) {
+        case SampleFormat::Float32:
+            sample.f32.resize(sample.frames);
+            for (auto& s : sample.f32) s = dist(rng) / 32768.f;
+            break;
+        case SampleFormat::Int16:
+            sample.i16.resize(sample.frames);
+            for (auto& s : sample.i16) s = static_cast<int16_t>(dist(rng));
+            break;
+        case SampleFormat::Int24:
+            sample.i24.resize(sample.frames * 3);
+            for (size_t i = 0; i < sample.frames; ++i) {
+                int v = dist(rng) * 256;
+                sample.i24[i * 3 + 0] = static_cast<uint8_t>(v);
+                sample.i24[i * 3 + 1] = static_cast<uint8_t>(v >> 8);
+                sample.i24[i * 3 + 2] = static_cast<uint8_t>(v >> 16);
+            }
+            break;
+    }
+
+    return sample;
+}
+
+} // namespace
+
+int runBenchmark(float sampleRate) {
+    std::vector<float> mix(cfg::MIX_FRAMES * 2);
+    std::vector<float> scratch(cfg::DECODE_FRAMES);
+
+    const double blockSeconds = cfg::MIX_FRAMES / static_cast<double>(sampleRate);
+
+    // Best of several runs, since a single run is easily skewed by the scheduler
+    std::printf("%u voices, %d-frame blocks at %.0f Hz, pitch spread over +-1 octave, best of %d runs\n",
+                static_cast<unsigned>(BENCH_VOICES), cfg::MIX_FRAMES, sampleRate, BENCH_RUNS);
+    std::printf("%-8s %-8s %12s %14s %14s %12s\n", "interp", "format", "bytes/frame", "ns/voice/block",
+                "voices/core", "vs float32");
+
+    for (Interpolation interp : { Interpolation::Linear, Interpolation::Sinc }) {
+        double floatPerVoiceBlock = 0.0;
+
+        for (SampleFormat format : { SampleFormat::Float32, SampleFormat::Int16, SampleFormat::Int24 }) {
+            SampleData sample = makeNoise(format, static_cast<int>(sampleRate));
+            const VoiceKernel& kernel = selectVoiceKernel(interp, sample);
+
+            std::mt19937 rng(2);
+            std::uniform_real_distribution<float> octave(-1.f, 1.f);
+            std::vector<float> steps(BENCH_VOICES);
+            std::vector<double> pos(BENCH_VOICES, 0.0);
+            for (auto& s : steps) s = std::exp2(octave(rng));
+
+            double perVoiceBlock = 0.0;
+            for (int run = 0; run < BENCH_RUNS; ++run) {
+                auto begin = std::chrono::steady_clock::now();
+
+                for (size_t b = 0; b < BENCH_BLOCKS; ++b) {
+                    std::fill(mix.begin(), mix.end(), 0.f);
+                    for (size_t v = 0; v < BENCH_VOICES; ++v) {
+                        if (!kernel.steady(sample, pos[v], steps[v], steps[v], 0.1f,
+                                           mix.data(), cfg::MIX_FRAMES, scratch.data())) {
+                            pos[v] = 0.0;
+                        }
+                    }
+                }
+
+                std::chrono::duration<double> took = std::chrono::steady_clock::now() - begin;
+                double t = took.count() / (BENCH_BLOCKS * BENCH_VOICES);
+                if (run == 0 || t < perVoiceBlock) perVoiceBlock = t;
+            }
+
+            if (format == SampleFormat::Float32) floatPerVoiceBlock = perVoiceBlock;
+
+            std::printf("%-8s %-8s %12zu %14.0f %14.0f %11.2fx\n", interpolationName(interp), sampleFormatName(format),
+                        bytesPerFrame(format), perVoiceBlock * 1e9, blockSeconds / perVoiceBlock,
+                        perVoiceBlock / floatPerVoiceBlock);
+        }
+    }
+
+    // Each master effect alone over the same noise, timed by the chain's own counters
+    std::printf("\n%-8s %14s %14s\n", "effect", "ns/block", "% of real time");
+
+    SampleData noise = makeNoise(SampleFormat::Float32, static_cast<int>(sampleRate));
+    EffectChain chain(sampleRate);
+
+    for (size_t i = 0; i < chain.size(); ++i) {
+        for (size_t j = 0; j < chain.size(); ++j) chain.setBypass(j, j != i);
+
+        for (size_t b = 0; b < BENCH_BLOCKS; ++b) {
+            const float* src = noise.f32.data() + (b * cfg::MIX_FRAMES * 2) % (noise.f32.size() - cfg::MIX_FRAMES * 2);
+            std::copy_n(src, cfg::MIX_FRAMES * 2, mix.data());
+            chain.process(mix.data(), cfg::MIX_FRAMES);
+        }
+
+        double perBlock = chain.cpuNanoseconds(i) / 1e9 / BENCH_BLOCKS;
+        std::printf("%-8s %14.0f %14.3f\n", chain.name(i), perBlock * 1e9, perBlock / blockSeconds * 100.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,345 @@
+#include "Effects.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+    #include <immintrin.h>
+    #define EFFECTS_SSE 1
+#else
+    #define EFFECTS_SSE 0
+#endif
+
+namespace {
+
+// Freeverb's tunings at 44.1 kHz, scaled to the output rate
+constexpr size_t COMB_LENGTHS[] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+constexpr size_t ALLPASS_LENGTHS[] = { 556, 441, 341, 225 };
+constexpr size_t STEREO_SPREAD = 23;
+constexpr float REVERB_INPUT_GAIN = 0.015f;
+constexpr float ALLPASS_FEEDBACK = 0.5f;
+
+size_t scaledLength(size_t length, float sampleRate) {
+    return std::max<size_t>(1, static_cast<size_t>(length * sampleRate / 44100.f));
+}
+
+} // namespace
+
+Biquad Biquad::design(Type type, float sampleRate, float hz, float gainDb, float q) {
+    const double w0 = 2.0 * M_PI * hz / sampleRate;
+    const double cw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double A = std::pow(10.0, gainDb / 40.0);
+    const double sa = 2.0 * std::sqrt(A) * alpha;
+
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (type) {
+        case Type::HighPass:
+            b0 = (1.0 + cw) / 2.0;
+            b1 = -(1.0 + cw);
+            b2 = (1.0 + cw) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cw;
+            a2 = 1.0 - alpha;
+            break;
+        case Type::LowShelf:
+            b0 = A * ((A + 1.0) - (A - 1.0) * cw + sa);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cw - sa);
+            a0 = (A + 1.0) + (A - 1.0) * cw + sa;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+            a2 = (A + 1.0) + (A - 1.0) * cw - sa;
+            break;
+        case Type::Peak:
+            b0 = 1.0 + alpha * A;
+            b1 = -2.0 * cw;
+            b2 = 1.0 - alpha * A;
+            a0 = 1.0 + alpha / A;
+            a1 = -2.0 * cw;
+            a2 = 1.0 - alpha / A;
+            break;
+        case Type::HighShelf:
+        default:
+            b0 = A * ((A + 1.0) + (A - 1.0) * cw + sa);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cw - sa);
+            a0 = (A + 1.0) - (A - 1.0) * cw + sa;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+            a2 = (A + 1.0) - (A - 1.0) * cw - sa;
+            break;
+    }
+
+    Biquad bq;
+    bq.b0 = static_cast<float>(b0 / a0);
+    bq.b1 = static_cast<float>(b1 / a0);
+    bq.b2 = static_cast<float>(b2 / a0);
+    bq.a1 = static_cast<float>(a1 / a0);
+    bq.a2 = static_cast<float>(a2 / a0);
+    return bq;
+}
+
+EqEffect::EqEffect(float sampleRate)
+    : bands_{ Biquad::design(Biquad::Type::HighPass, sampleRate, cfg::EQ_HIGHPASS_HZ, 0.f, 0.7071f),
+              Biquad::design(Biquad::Type::LowShelf, sampleRate, cfg::EQ_LOW_SHELF_HZ, cfg::EQ_LOW_SHELF_DB, 0.7071f),
+              Biquad::design(Biquad::Type::HighShelf, sampleRate, cfg::EQ_HIGH_SHELF_HZ, cfg::EQ_HIGH_SHELF_DB, 0.7071f) }
+{
+    std::memset(state_, 0, sizeof(state_));
+}
+
+void EqEffect::process(float* data, size_t frames) {
+    // Transposed direct form II. All bands run in one pass, so the out-of-order core can
+    // overlap one band's recursion with the next band working on the previous frame.
+#if EFFECTS_SSE
+    __m128 b0[BANDS], b1[BANDS], b2[BANDS], a1[BANDS], a2[BANDS], z1[BANDS], z2[BANDS];
+    for (size_t b = 0; b < BANDS; ++b) {
+        b0[b] = _mm_set1_ps(bands_[b].b0);
+        b1[b] = _mm_set1_ps(bands_[b].b1);
+        b2[b] = _mm_set1_ps(bands_[b].b2);
+        a1[b] = _mm_set1_ps(bands_[b].a1);
+        a2[b] = _mm_set1_ps(bands_[b].a2);
+        z1[b] = _mm_load_ps(state_[b][0]);
+        z2[b] = _mm_load_ps(state_[b][1]);
+    }
+
+    for (size_t k = 0; k < frames; ++k) {
+        __m64* frame = reinterpret_cast<__m64*>(data + k * 2);
+        __m128 x = _mm_loadl_pi(_mm_setzero_ps(), frame);
+
+        for (size_t b = 0; b < BANDS; ++b) {
+            __m128 y = _mm_add_ps(_mm_mul_ps(b0[b], x), z1[b]);
+            z1[b] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[b], x), _mm_mul_ps(a1[b], y)), z2[b]);
+            z2[b] = _mm_sub_ps(_mm_mul_ps(b2[b], x), _mm_mul_ps(a2[b], y));
+            x = y;
+        }
+
+        _mm_storel_pi(frame, x);
+    }
+
+    for (size_t b = 0; b < BANDS; ++b) {
+        _mm_store_ps(state_[b][0], z1[b]);
+        _mm_store_ps(state_[b][1], z2[b]);
+    }
+#else
+    for (size_t k = 0; k < frames; ++k) {
+        for (size_t c = 0; c < 2; ++c) {
+            float x = data[k * 2 + c];
+            for (size_t b = 0; b < BANDS; ++b) {
+                const Biquad& bq = bands_[b];
+                float y = bq.b0 * x + state_[b][0][c];
+                state_[b][0][c] = bq.b1 * x - bq.a1 * y + state_[b][1][c];
+                state_[b][1][c] = bq.b2 * x - bq.a2 * y;
+                x = y;
+            }
+            data[k * 2 + c] = x;
+        }
+    }
+#endif
+}
+
+void EqEffect::reset() {
+    std::memset(state_, 0, sizeof(state_));
+}
+
+DelayEffect::DelayEffect(float sampleRate)
+    : write_(0),
+      delay_(static_cast<size_t>(cfg::DELAY_MS * 0.001f * sampleRate)),
+      lowpass_{ 0.f, 0.f }
+{
+    size_t frames = std::bit_ceil(static_cast<size_t>(cfg::DELAY_MAX_MS * 0.001f * sampleRate) + 1);
+    buffer_.assign(frames * 2, 0.f);
+    mask_ = frames - 1;
+    delay_ = std::clamp<size_t>(delay_, 1, mask_);
+}
+
+void DelayEffect::process(float* data, size_t frames) {
+    const float keep = cfg::DELAY_DAMPING;
+    float* buffer = buffer_.data();
+
+    for (size_t k = 0; k < frames; ++k) {
+        size_t read = (write_ - delay_) & mask_;
+
+        for (size_t c = 0; c < 2; ++c) {
+            float delayed = buffer[read * 2 + c];
+            lowpass_[c] = delayed + (lowpass_[c] - delayed) * keep;
+
+            float x = data[k * 2 + c];
+            buffer[write_ * 2 + c] = x + lowpass_[c] * cfg::DELAY_FEEDBACK;
+            data[k * 2 + c] = x + delayed * cfg::DELAY_MIX;
+        }
+
+        write_ = (write_ + 1) & mask_;
+    }
+}
+
+void DelayEffect::reset() {
+    // Only the delay_ frames behind write_ are read before being overwritten, clearing those
+    // is enough and keeps the cost to one delay time instead of the whole ring
+    size_t start = (write_ - delay_) & mask_;
+    size_t first = std::min(delay_, mask_ + 1 - start);
+    std::fill_n(buffer_.data() + start * 2, first * 2, 0.f);
+    std::fill_n(buffer_.data(), (delay_ - first) * 2, 0.f);
+
+    lowpass_[0] = lowpass_[1] = 0.f;
+}
+
+ReverbEffect::ReverbEffect(float sampleRate) {
+    for (size_t c = 0; c < 2; ++c) {
+        size_t spread = c ? STEREO_SPREAD : 0;
+        for (size_t i = 0; i < COMBS; ++i) combs_[c][i].buffer.assign(scaledLength(COMB_LENGTHS[i] + spread, sampleRate), 0.f);
+        for (size_t i = 0; i < ALLPASSES; ++i) allpasses_[c][i].buffer.assign(scaledLength(ALLPASS_LENGTHS[i] + spread, sampleRate), 0.f);
+    }
+}
+
+void ReverbEffect::process(float* data, size_t frames) {
+    const float feedback = cfg::REVERB_ROOM * 0.28f + 0.7f;
+    const float damp = cfg::REVERB_DAMPING * 0.4f;
+    const float wet1 = cfg::REVERB_WET * (cfg::REVERB_WIDTH / 2.f + 0.5f);
+    const float wet2 = cfg::REVERB_WET * ((1.f - cfg::REVERB_WIDTH) / 2.f);
+
+    for (size_t k = 0; k < frames; ++k) input_[k] = (data[k * 2] + data[k * 2 + 1]) * REVERB_INPUT_GAIN;
+
+    // Filter by filter over the block, so only one delay line is streamed at a time
+    for (size_t c = 0; c < 2; ++c) {
+        float* wet = wet_[c].data();
+        std::fill_n(wet, frames, 0.f);
+
+        for (auto& comb : combs_[c]) {
+            float* buffer = comb.buffer.data();
+            const size_t size = comb.buffer.size();
+            size_t pos = comb.pos;
+            float store = comb.store;
+
+            for (size_t k = 0; k < frames; ++k) {
+                float y = buffer[pos];
+                store = y + (store - y) * damp;
+                buffer[pos] = input_[k] + store * feedback;
+                if (++pos == size) pos = 0;
+                wet[k] += y;
+            }
+
+            comb.pos = pos;
+            comb.store = store;
+        }
+
+        for (auto& allpass : allpasses_[c]) {
+            float* buffer = allpass.buffer.data();
+            const size_t size = allpass.buffer.size();
+            size_t pos = allpass.pos;
+
+            for (size_t k = 0; k < frames; ++k) {
+                float delayed = buffer[pos];
+                buffer[pos] = wet[k] + delayed * ALLPASS_FEEDBACK;
+                wet[k] = delayed - wet[k];
+                if (++pos == size) pos = 0;
+            }
+
+            allpass.pos = pos;
+        }
+    }
+
+    for (size_t k = 0; k < frames; ++k) {
+        float l = wet_[0][k], r = wet_[1][k];
+        data[k * 2] += l * wet1 + r * wet2;
+        data[k * 2 + 1] += r * wet1 + l * wet2;
+    }
+}
+
+void ReverbEffect::reset() {
+    for (auto& channel : combs_) {
+        for (auto& comb : channel) {
+            std::fill(comb.buffer.begin(), comb.buffer.end(), 0.f);
+            comb.store = 0.f;
+        }
+    }
+    for (auto& channel : allpasses_) {
+        for (auto& allpass : channel) std::fill(allpass.buffer.begin(), allpass.buffer.end(), 0.f);
+    }
+}
+
+LimiterEffect::LimiterEffect(float sampleRate)
+    : release_(std::exp(-1.f / (cfg::LIMITER_RELEASE_MS * 0.001f * sampleRate))),
+      envelope_(0.f)
+{
+}
+
+void LimiterEffect::process(float* data, size_t frames) {
+    float envelope = envelope_;
+
+    for (size_t k = 0; k < frames; ++k) {
+        float peak = std::max(std::fabs(data[k * 2]), std::fabs(data[k * 2 + 1]));
+        envelope = std::max(peak, envelope * release_);
+
+        // The envelope is never below the current peak, so scaling by ceiling / envelope cannot overshoot
+        if (envelope > cfg::LIMITER_CEILING) {
+            float gain = cfg::LIMITER_CEILING / envelope;
+            data[k * 2] *= gain;
+            data[k * 2 + 1] *= gain;
+        }
+    }
+
+    envelope_ = envelope;
+}
+
+void LimiterEffect::reset() {
+    envelope_ = 0.f;
+}
+
+EffectChain::EffectChain(float sampleRate, uint32_t bypass)
+    : sampleRate_(sampleRate),
+      effects_{ std::make_unique<EqEffect>(sampleRate),
+                std::make_unique<DelayEffect>(sampleRate),
+                std::make_unique<ReverbEffect>(sampleRate),
+                std::make_unique<LimiterEffect>(sampleRate) },
+      bypass_(bypass),
+      processedBypass_(bypass)
+{
+}
+
+int EffectChain::find(std::string_view name) {
+    for (size_t i = 0; i < NUM_EFFECTS; ++i) {
+        if (name == NAMES[i]) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void EffectChain::setBypass(size_t idx, bool bypass) {
+    if (bypass) bypass_.fetch_or(1u << idx, std::memory_order_relaxed);
+    else bypass_.fetch_and(~(1u << idx), std::memory_order_relaxed);
+}
+
+void EffectChain::process(float* data, size_t frames, size_t first, size_t last) {
+    using clock = std::chrono::steady_clock;
+
+    // Bypassed effects are skipped outright and reset when they come back
+    const uint32_t bypass = bypass_.load(std::memory_order_relaxed);
+
+    for (size_t i = first; i < last; ++i) {
+        const uint32_t bit = 1u << i;
+        const uint32_t was = processedBypass_ & bit;
+        processedBypass_ = (processedBypass_ & ~bit) | (bypass & bit);
+
+        if (bypass & bit) continue;
+
+        auto begin = clock::now();
+        if (was) effects_[i]->reset();
+        effects_[i]->process(data, frames);
+        auto took = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin).count();
+
+        stats_[i].nanoseconds.fetch_add(static_cast<uint64_t>(took), std::memory_order_relaxed);
+        stats_[i].frames.fetch_add(frames, std::memory_order_relaxed);
+    }
+}
+
+void EffectChain::report() const {
+    for (size_t i = 0; i < NUM_EFFECTS; ++i) {
+        double audio = framesProcessed(i) / static_cast<double>(sampleRate_) * 1e9;
+        double share = audio > 0.0 ? cpuNanoseconds(i) / audio * 100.0 : 0.0;
+        std::printf("Effect %zu %-8s %-8s %6.3f%% of real time\n",
+                    i + 1, name(i), bypassed(i) ? "bypassed" : "on", share);
+    }
+}
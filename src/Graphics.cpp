@@ -4,11 +4,14 @@
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
 
 Graphics* Graphics::s_instance_ = nullptr;
 
 Graphics::Graphics(Audio& audio)
-    : audio_(audio), window_(nullptr)
+    : audio_(audio), window_(nullptr), meterDisplay_{}
 {
     glfwSetErrorCallback([](int error, const char *desc) {
         std::fprintf(stderr, "GLFW Error %d: %s\n", error, desc);
@@ -28,6 +31,7 @@ Graphics::Graphics(Audio& audio)
     glfwMakeContextCurrent(window_);
     glfwSetDropCallback(window_, &Graphics::dropCallbackStatic);
     glfwSetCursorPosCallback(window_, &Graphics::cursorPosCallbackStatic);
+    glfwSetKeyCallback(window_, &Graphics::keyCallbackStatic);
 
     if (glewInit() != GLEW_OK) {
         glfwDestroyWindow(window_);
@@ -92,6 +96,38 @@ void Graphics::cursorPosCallbackStatic(GLFWwindow* window, double xpos, double y
     }
 }
 
+void Graphics::keyCallbackStatic(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    (void) window;
+    (void) scancode;
+    (void) mods;
+
+    if (!s_instance_ || action != GLFW_PRESS) return;
+
+    if (key == GLFW_KEY_R) {
+        Recorder& recorder = s_instance_->audio_.recorder();
+
+        if (recorder.recording()) {
+            recorder.stop();
+        } else {
+            char name[64];
+            std::time_t now = std::time(nullptr);
+            std::strftime(name, sizeof(name), "recording-%Y%m%d-%H%M%S.wav", std::localtime(&now));
+            recorder.start(name);
+        }
+    }
+
+    // 1..4 toggle the master effects, E prints what each of them costs
+    EffectChain& effects = s_instance_->audio_.effects();
+
+    if (key >= GLFW_KEY_1 && key < GLFW_KEY_1 + static_cast<int>(effects.size())) {
+        size_t idx = static_cast<size_t>(key - GLFW_KEY_1);
+        effects.setBypass(idx, !effects.bypassed(idx));
+        std::printf("Effect %s %s\n", effects.name(idx), effects.bypassed(idx) ? "bypassed" : "on");
+    }
+
+    if (key == GLFW_KEY_E) effects.report();
+}
+
 void Graphics::fillRect(float x, float y, float w, float h, float r, float g, float b) {
     glColor3f(r, g, b);
     glBegin(GL_QUADS);
@@ -124,7 +160,24 @@ void Graphics::drawPerc(float x, float y, float w, float h, float r, float g, fl
     fillRect(x + BW, y + BW, w - 2 * BW, h - 2 * BW, v, v, v);
 }
 
+void Graphics::drawMeter(float x, float y, float w, float h, const MeterLevel& level) {
+    // -60 dBFS at the bottom to 0 dBFS at the top
+    auto height = [h](float v) {
+        float db = 20.f * std::log10(std::max(v, 1e-6f));
+        return std::clamp((db + 60.f) / 60.f, 0.f, 1.f) * h;
+    };
+
+    fillRect(x, y, w, h, 0.f, 0.f, 0.f);
+    fillRect(x, y, w, height(level.rms), 0.f, .8f, 0.f);
+
+    float py = height(level.peak);
+    if (level.peak >= 1.f) fillRect(x, y + h - 3.f, w, 3.f, 1.f, 0.f, 0.f);
+    else fillRect(x, y + std::max(py - 2.f, 0.f), w, 2.f, 1.f, 1.f, 0.f);
+}
+
 void Graphics::run() {
+    const float METER_WIDTH = 10.f;
+
     while (!glfwWindowShouldClose(window_)) {
         audio_.computeSpectrum();
 
@@ -183,15 +236,24 @@ void Graphics::run() {
         float percKeyWidth = width / 2 / 4;
         float percKeyHeight = (height - pianoHeight) / 2;
 
+        // Meters fall back slowly so short peaks stay visible at the frame rate
+        for (size_t m = 0; m < Audio::NUM_METERS; ++m) {
+            MeterLevel level = audio_.takeMeter(m);
+            meterDisplay_[m].peak = std::max(level.peak, meterDisplay_[m].peak * 0.95f);
+            meterDisplay_[m].rms = std::max(level.rms, meterDisplay_[m].rms * 0.9f);
+        }
+
         for (int py = 0; py < 2; py++) {
             for (int px = 0; px < 4; px++) {
                 int idx = px + py * 4;
 
                 auto color = percColors_[idx];
+                float x = percStartX + px * percKeyWidth;
+                float y = pianoHeight + (1 - py) * percKeyHeight;
                 
                 drawPerc(
-                    percStartX + px * percKeyWidth,
-                    pianoHeight + (1 - py) * percKeyHeight,
+                    x,
+                    y,
                     percKeyWidth,
                     percKeyHeight,
                     color[0],
@@ -199,14 +261,23 @@ void Graphics::run() {
                     color[2],
                     perc[idx] / 127.f
                 );
+
+                drawMeter(x + percKeyWidth - 8.f - METER_WIDTH, y + 8.f, METER_WIDTH, percKeyHeight - 16.f,
+                          meterDisplay_[Audio::METER_PERC + idx]);
             }
         }
 
+        // Master and piano meters sit between the spectrum and the pads
+        drawMeter(percStartX - 2 * (METER_WIDTH + 4.f), pianoHeight + 4.f, METER_WIDTH, height - pianoHeight - 8.f,
+                  meterDisplay_[Audio::METER_PIANO]);
+        drawMeter(percStartX - (METER_WIDTH + 4.f), pianoHeight + 4.f, METER_WIDTH, height - pianoHeight - 8.f,
+                  meterDisplay_[Audio::METER_MASTER]);
+
         // Spectrum
 
         auto spectrum = audio_.getSpectrumCopy();
 
-        int spectrumWidth = width / 2;
+        int spectrumWidth = width / 2 - static_cast<int>(2 * (METER_WIDTH + 4.f)) - 4;
         float minFreq = 20.f;
         float maxFreq = 20000.f;
         float logMin = std::log10(minFreq);
@@ -217,7 +288,7 @@ void Graphics::run() {
             float logFreq = logMin + frac * (logMax - logMin);
             float freq = std::pow(10.f, logFreq);
 
-            float bin = freq * cfg::FFT_SIZE / cfg::OUTPUT_SAMPLE_RATE;
+            float bin = freq * cfg::FFT_SIZE / audio_.sampleRate();
             int bin0 = static_cast<int>(std::floor(bin));
             int bin1 = bin0 + 1;
             float ffrac = bin - bin0;
@@ -0,0 +1,17 @@
+#include "Kaiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+double kaiserWindow(double t, double beta) {
+    return besselI0(beta * std::sqrt(std::max(0.0, 1.0 - t * t))) / besselI0(beta);
+}
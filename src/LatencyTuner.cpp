@@ -0,0 +1,91 @@
+#include "LatencyTuner.hpp"
+
+#include <cstdio>
+#include <exception>
+
+LatencyTuner::LatencyTuner(Audio& audio, std::string outputSpec)
+    : audio_(audio), outputSpec_(std::move(outputSpec)), stopped_(false)
+{
+}
+
+void LatencyTuner::run() {
+    bool settled = false;
+    for (unsigned long frames = cfg::TUNE_MIN_FRAMES; !settled && frames < cfg::TUNE_MAX_FRAMES; frames *= 2) {
+        settled = tryFrames(frames);
+        if (stopped_) return;
+    }
+
+    // Nothing smaller held up, settle on the largest buffer without judging it
+    if (!settled) tryFrames(cfg::TUNE_MAX_FRAMES);
+    if (stopped_) return;
+
+    std::printf("Tuner: settled on %lu frames, start with --frames=%lu to skip tuning\n",
+                audio_.outputFrames(), audio_.outputFrames());
+}
+
+void LatencyTuner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    wake_.notify_all();
+}
+
+bool LatencyTuner::wait(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return !wake_.wait_for(lock, duration, [this]() { return stopped_.load(); });
+}
+
+bool LatencyTuner::switchTo(unsigned long frames) {
+    const StreamConfig previous{ audio_.sampleRate(), audio_.outputFrames() };
+
+    // The new stream is opened while the current one keeps playing, so a rejected size costs nothing
+    try {
+        audio_.setOutput(Output::create(outputSpec_, { audio_.sampleRate(), frames }));
+        return true;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Tuner: %lu frames rejected: %s\n", frames, e.what());
+    }
+
+    // Devices that can only be opened once need the current stream closed first
+    try {
+        audio_.setOutput(nullptr);
+        audio_.setOutput(Output::create(outputSpec_, { audio_.sampleRate(), frames }));
+        return true;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Tuner: %lu frames rejected after closing the stream: %s\n", frames, e.what());
+    }
+
+    try {
+        if (previous.frames) audio_.setOutput(Output::create(outputSpec_, previous));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Tuner: cannot restore %lu frames, audio is off: %s\n", previous.frames, e.what());
+    }
+    return false;
+}
+
+bool LatencyTuner::tryFrames(unsigned long frames) {
+    if (!switchTo(frames)) return false;
+
+    // Let the stream settle before counting, startup often underruns once
+    if (!wait(std::chrono::milliseconds(200))) return false;
+    uint64_t xruns = audio_.outputXruns();
+    audio_.takePeakLoad();
+
+    if (!wait(std::chrono::seconds(cfg::TUNE_SECONDS))) return false;
+
+    xruns = audio_.outputXruns() - xruns;
+    float load = audio_.takePeakLoad();
+    unsigned long granted = audio_.outputFrames();
+
+    // A dead stream shows no xruns and no load, so it has to be ruled out explicitly
+    bool failed = audio_.outputFailed();
+    bool stable = !failed && xruns == 0 && load < cfg::TUNE_MAX_LOAD;
+
+    std::printf("Tuner: %lu frames (%.2f ms), %llu xruns, peak load %.0f%% -> %s\n",
+                granted, 1000.f * granted / audio_.sampleRate(),
+                static_cast<unsigned long long>(xruns), 100.f * load,
+                failed ? "stream failed" : stable ? "stable" : "unstable");
+
+    return stable;
+}
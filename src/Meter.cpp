@@ -0,0 +1,92 @@
+#include "Meter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+    #include <immintrin.h>
+    #define METER_SSE 1
+#else
+    #define METER_SSE 0
+#endif
+
+namespace {
+
+#if METER_SSE
+inline void reduce(__m128 vpeak, __m128 vsum, float& peak, float& sumSquares) {
+    alignas(16) float p[4], s[4];
+    _mm_store_ps(p, vpeak);
+    _mm_store_ps(s, vsum);
+    peak = std::max({ peak, p[0], p[1], p[2], p[3] });
+    sumSquares += (s[0] + s[1]) + (s[2] + s[3]);
+}
+#endif
+
+} // namespace
+
+void Meter::publish(float peak, float sumSquares, size_t samples) {
+    float held = peak_.load(std::memory_order_relaxed);
+    while (peak > held && !peak_.compare_exchange_weak(held, peak, std::memory_order_relaxed)) {}
+
+    rms_.store(samples ? std::sqrt(sumSquares / samples) : 0.f, std::memory_order_relaxed);
+}
+
+MeterLevel Meter::take() {
+    return { peak_.exchange(0.f, std::memory_order_relaxed), rms_.load(std::memory_order_relaxed) };
+}
+
+void accumulateMeasured(float* dst, const float* src, size_t count, float& peak, float& sumSquares) {
+    size_t i = 0;
+#if METER_SSE
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vpeak = _mm_setzero_ps();
+    __m128 vsum = _mm_setzero_ps();
+    __m128 vsum2 = _mm_setzero_ps();
+
+    // Two sums in flight so the adds do not wait on each other
+    for (; i + 8 <= count; i += 8) {
+        __m128 x = _mm_loadu_ps(src + i);
+        __m128 y = _mm_loadu_ps(src + i + 4);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), x));
+        _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_loadu_ps(dst + i + 4), y));
+        vpeak = _mm_max_ps(vpeak, _mm_max_ps(_mm_and_ps(x, absMask), _mm_and_ps(y, absMask)));
+        vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+        vsum2 = _mm_add_ps(vsum2, _mm_mul_ps(y, y));
+    }
+
+    reduce(vpeak, _mm_add_ps(vsum, vsum2), peak, sumSquares);
+#endif
+    for (; i < count; ++i) {
+        dst[i] += src[i];
+        peak = std::max(peak, std::fabs(src[i]));
+        sumSquares += src[i] * src[i];
+    }
+}
+
+void scaleMeasured(float* dst, const float* src, size_t count, float gain, float& peak, float& sumSquares) {
+    size_t i = 0;
+#if METER_SSE
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 vgain = _mm_set1_ps(gain);
+    __m128 vpeak = _mm_setzero_ps();
+    __m128 vsum = _mm_setzero_ps();
+    __m128 vsum2 = _mm_setzero_ps();
+
+    for (; i + 8 <= count; i += 8) {
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(src + i), vgain);
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(src + i + 4), vgain);
+        _mm_storeu_ps(dst + i, x);
+        _mm_storeu_ps(dst + i + 4, y);
+        vpeak = _mm_max_ps(vpeak, _mm_max_ps(_mm_and_ps(x, absMask), _mm_and_ps(y, absMask)));
+        vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+        vsum2 = _mm_add_ps(vsum2, _mm_mul_ps(y, y));
+    }
+
+    reduce(vpeak, _mm_add_ps(vsum, vsum2), peak, sumSquares);
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * gain;
+        peak = std::max(peak, std::fabs(dst[i]));
+        sumSquares += dst[i] * dst[i];
+    }
+}
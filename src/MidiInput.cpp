@@ -0,0 +1,60 @@
+#include "MidiInput.hpp"
+#include "Config.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+bool decodeMidiMessage(uint8_t status, uint8_t data1, uint8_t data2, bool pads, MidiEvent& event) {
+    uint8_t type = status & 0xf0;
+    pads = pads || (status & 0x0f) == cfg::MIDI_DRUM_CHANNEL;
+
+    switch (type) {
+        case 0x80:
+        case 0x90: {
+            // Note on with zero velocity is a note off
+            bool on = type == 0x90 && data2 > 0;
+
+            if (!pads) {
+                event = { on ? MidiEvent::Type::NoteOn : MidiEvent::Type::NoteOff, data1, data2 };
+                return true;
+            }
+
+            auto pad = std::find(std::begin(cfg::PAD_NOTES), std::end(cfg::PAD_NOTES), data1);
+            if (pad == std::end(cfg::PAD_NOTES)) return false;
+
+            event = { on ? MidiEvent::Type::PadOn : MidiEvent::Type::PadOff,
+                      static_cast<uint8_t>(pad - std::begin(cfg::PAD_NOTES)), data2 };
+            return true;
+        }
+        case 0xe0:
+            event = { MidiEvent::Type::PitchBend, 0, data2 };
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::unique_ptr<MidiInput> MidiInput::create(std::string_view spec, const InputConfig& config) {
+    std::string_view kind = spec.substr(0, spec.find(':'));
+    std::string arg = spec.size() > kind.size() ? std::string(spec.substr(kind.size() + 1)) : std::string();
+
+    if (kind != "usb" && !config.capturePath.empty()) {
+        std::fprintf(stderr, "MIDI capture records raw USB packets only, ignoring it for %.*s input\n",
+                     static_cast<int>(kind.size()), kind.data());
+    }
+
+    if (kind == "usb") {
+        if (arg.empty()) throw std::runtime_error("usb input needs a device, e.g. usb:/dev/bus/usb/001/005");
+        return std::make_unique<UsbMidiInput>(arg, config.capturePath);
+    }
+    if (kind == "replay") {
+        if (arg.empty()) throw std::runtime_error("replay input needs a path, e.g. replay:take.mlog");
+        return std::make_unique<ReplayMidiInput>(arg, !config.replayFast, config.replayClock);
+    }
+    if (kind == "seq") return std::make_unique<SeqMidiInput>(arg);
+    if (kind == "rawmidi") return std::make_unique<RawMidiInput>(arg.empty() ? "default" : arg);
+
+    throw std::runtime_error("Unknown input: " + std::string(spec));
+}
@@ -0,0 +1,131 @@
+#include "MidiLog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr char MAGIC[8] = { 'M', 'I', 'D', 'I', 'L', 'O', 'G', '1' };
+
+// Writes go through stdio with this much buffering, so the device thread never waits on
+// the disk for a single packet. A kill loses at most this much of the log.
+constexpr size_t WRITE_BUFFER_BYTES = 64 * 1024;
+
+} // namespace
+
+MidiLogWriter::MidiLogWriter(const std::string& path)
+    : file_(std::fopen(path.c_str(), "wb")),
+      buffer_(WRITE_BUFFER_BYTES),
+      last_(std::chrono::steady_clock::now()),
+      packets_(0)
+{
+    if (!file_) throw std::runtime_error("Failed to open MIDI capture: " + path);
+    std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file_);
+}
+
+MidiLogWriter::~MidiLogWriter() {
+    std::fclose(file_);
+    std::printf("MIDI capture: %llu packets\n", static_cast<unsigned long long>(packets_));
+}
+
+void MidiLogWriter::write(uint8_t address, const uint8_t* data, uint8_t count) {
+    auto now = std::chrono::steady_clock::now();
+    uint64_t delta = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+    last_ = now;
+
+    uint8_t header[12];
+    size_t size = 0;
+    do {
+        header[size++] = static_cast<uint8_t>((delta & 0x7f) | (delta > 0x7f ? 0x80 : 0));
+        delta >>= 7;
+    } while (delta);
+    header[size++] = address;
+    header[size++] = count;
+
+    std::fwrite(header, 1, size, file_);
+    std::fwrite(data, 1, count, file_);
+    ++packets_;
+}
+
+MidiLogPlayer::MidiLogPlayer(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open MIDI log: " + path);
+
+    data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (data_.size() < sizeof(MAGIC) || std::memcmp(data_.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a MIDI log: " + path);
+    }
+}
+
+void MidiLogPlayer::run(USB::callback_t callback, bool realtime) {
+    std::chrono::nanoseconds worstLate{0}, totalLate{0};
+
+    auto begin = std::chrono::steady_clock::now();
+    wait_t wait;
+    if (realtime) {
+        wait = [&](std::chrono::nanoseconds offset) {
+            auto due = begin + offset;
+            std::this_thread::sleep_until(due);
+            auto late = std::chrono::steady_clock::now() - due;
+            worstLate = std::max(worstLate, late);
+            totalLate += late;
+        };
+    }
+
+    uint64_t packets = play(callback, wait);
+
+    std::chrono::duration<double> took = std::chrono::steady_clock::now() - begin;
+    std::printf("MIDI replay: %llu packets in %.3f s", static_cast<unsigned long long>(packets), took.count());
+    if (realtime && packets) {
+        std::printf(", dispatch late by %.1f us on average, %.1f us worst",
+                    totalLate.count() / 1e3 / packets, worstLate.count() / 1e3);
+    }
+    std::printf("\n");
+}
+
+void MidiLogPlayer::runPaced(USB::callback_t callback, const wait_t& wait) {
+    uint64_t packets = play(callback, wait);
+    std::printf("MIDI replay: %llu packets\n", static_cast<unsigned long long>(packets));
+}
+
+uint64_t MidiLogPlayer::play(const USB::callback_t& callback, const wait_t& wait) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data_.data()) + sizeof(MAGIC);
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(data_.data()) + data_.size();
+
+    uint8_t packet[256];
+    uint64_t packets = 0;
+    std::chrono::nanoseconds offset{0};
+
+    while (p < end) {
+        uint64_t delta = 0;
+        int shift = 0;
+        while (p < end && shift < 64) {
+            uint8_t byte = *p++;
+            delta |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            shift += 7;
+            if (!(byte & 0x80)) break;
+        }
+
+        if (end - p < 2) break;
+        uint8_t address = *p++;
+        uint8_t count = *p++;
+        if (end - p < count) break;
+
+        // Copied out since the callback takes a mutable buffer, like the one USB reads into
+        std::memcpy(packet, p, count);
+        p += count;
+
+        offset += std::chrono::nanoseconds(delta);
+        if (wait) wait(offset);
+
+        callback(address, packet, count);
+        ++packets;
+    }
+
+    return packets;
+}
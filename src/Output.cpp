@@ -0,0 +1,106 @@
+#include "Output.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+std::unique_ptr<Output> Output::create(std::string_view spec, const StreamConfig& config) {
+    std::string_view kind = spec.substr(0, spec.find(':'));
+    std::string arg = spec.size() > kind.size() ? std::string(spec.substr(kind.size() + 1)) : std::string();
+
+    if (kind == "portaudio") return std::make_unique<PortAudioOutput>(config);
+    if (kind == "alsa") return std::make_unique<AlsaOutput>(arg.empty() ? "default" : arg, config);
+    if (kind == "null") return std::make_unique<NullOutput>(config);
+    if (kind == "wav") {
+        if (arg.empty()) throw std::runtime_error("wav output needs a path, e.g. wav:out.wav");
+        return std::make_unique<WavOutput>(arg, config);
+    }
+
+    throw std::runtime_error("Unknown output: " + std::string(spec));
+}
+
+NullOutput::NullOutput(const StreamConfig& config)
+    : Output(config),
+      buffer_(config.frames * 2, 0.f),
+      running_(false)
+{
+}
+
+NullOutput::~NullOutput() {
+    stop();
+}
+
+void NullOutput::start(callback_t callback, thread_init_t threadInit) {
+    callback_ = std::move(callback);
+    threadInit_ = std::move(threadInit);
+
+    // Offline the caller renders, so it is also the thread to set up
+    if (config_.offline) {
+        if (threadInit_) threadInit_();
+        return;
+    }
+
+    running_.store(true);
+    thread_ = std::thread([this]() { run(); });
+}
+
+void NullOutput::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+}
+
+void NullOutput::step() {
+    callback_(buffer_.data(), config_.frames);
+    consume(buffer_.data(), config_.frames);
+}
+
+void NullOutput::consume(const float* data, unsigned long frames) {
+    (void) data;
+    (void) frames;
+}
+
+void NullOutput::run() {
+    using clock = std::chrono::steady_clock;
+
+    const auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(config_.frames / config_.sampleRate));
+
+    if (threadInit_) threadInit_();
+
+    auto next = clock::now();
+    while (running_.load()) {
+        callback_(buffer_.data(), config_.frames);
+        consume(buffer_.data(), config_.frames);
+
+        // Missing a deadline is what a real device would report as an underrun
+        next += period;
+        if (clock::now() > next) {
+            ++xruns_;
+            next = clock::now();
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+WavOutput::WavOutput(const std::string& path, const StreamConfig& config)
+    : NullOutput(config),
+      file_(nullptr)
+{
+    SF_INFO sfinfo{};
+    sfinfo.samplerate = static_cast<int>(config.sampleRate);
+    sfinfo.channels = 2;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+    file_ = sf_open(path.c_str(), SFM_WRITE, &sfinfo);
+    if (!file_) {
+        throw std::runtime_error("Failed to open " + path + ": " + sf_strerror(nullptr));
+    }
+}
+
+WavOutput::~WavOutput() {
+    stop();
+    sf_close(file_);
+}
+
+void WavOutput::consume(const float* data, unsigned long frames) {
+    sf_writef_float(file_, data, static_cast<sf_count_t>(frames));
+}
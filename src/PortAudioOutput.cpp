@@ -0,0 +1,102 @@
+#include "Output.hpp"
+
+#include <stdexcept>
+#include <string>
+
+PortAudioOutput::PortAudioOutput(const StreamConfig& config)
+    : Output(config),
+      threadStarted_(false),
+      stream_(nullptr)
+{
+    PaError err = Pa_Initialize();
+    if (err != paNoError) {
+        throw std::runtime_error("PortAudio init failed");
+    }
+}
+
+PortAudioOutput::~PortAudioOutput() {
+    stop();
+    Pa_Terminate();
+}
+
+void PortAudioOutput::start(callback_t callback, thread_init_t threadInit) {
+    callback_ = std::move(callback);
+    threadInit_ = std::move(threadInit);
+    threadStarted_ = false;
+
+    PaDeviceIndex device = paNoDevice;
+
+    {
+        int numDevices = Pa_GetDeviceCount();
+        for (int i = 0; i < numDevices; i++) {
+            const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
+            if (std::string("pipewire") == info->name) {
+                device = i;
+                break;
+            }
+        }
+    }
+
+    if (device == paNoDevice) device = Pa_GetDefaultOutputDevice();
+
+    if (device == paNoDevice) throw std::runtime_error("No default output device");
+
+    const PaDeviceInfo* devInfo = Pa_GetDeviceInfo(device);
+    PaStreamParameters outParams;
+    outParams.device = device;
+    outParams.channelCount = 2;
+    outParams.sampleFormat = paFloat32;
+    outParams.suggestedLatency = devInfo->defaultLowOutputLatency;
+    outParams.hostApiSpecificStreamInfo = nullptr;
+
+    PaError err = Pa_OpenStream(&stream_,
+                                nullptr,
+                                &outParams,
+                                config_.sampleRate,
+                                config_.frames,
+                                paNoFlag,
+                                &PortAudioOutput::paCallback,
+                                this);
+    if (err != paNoError) {
+        stream_ = nullptr;
+        throw std::runtime_error("Pa_OpenStream failed");
+    }
+
+    err = Pa_StartStream(stream_);
+    if (err != paNoError) {
+        Pa_CloseStream(stream_);
+        stream_ = nullptr;
+        throw std::runtime_error("Pa_StartStream failed");
+    }
+}
+
+void PortAudioOutput::stop() {
+    if (stream_) {
+        Pa_StopStream(stream_);
+        Pa_CloseStream(stream_);
+        stream_ = nullptr;
+    }
+}
+
+int PortAudioOutput::paCallback(const void* input, void* output,
+                                unsigned long framesPerBuffer,
+                                const PaStreamCallbackTimeInfo* timeInfo,
+                                PaStreamCallbackFlags statusFlags,
+                                void* userData)
+{
+    (void) input;
+    (void) timeInfo;
+
+    PortAudioOutput* self = static_cast<PortAudioOutput*>(userData);
+    if (statusFlags & paOutputUnderflow) ++self->xruns_;
+
+    // PortAudio creates its callback thread internally without a start hook,
+    // so the first callback is the earliest point on that thread
+    if (!self->threadStarted_) {
+        self->threadStarted_ = true;
+        if (self->threadInit_) self->threadInit_();
+    }
+
+    self->callback_(static_cast<float*>(output), framesPerBuffer);
+    return paContinue;
+}
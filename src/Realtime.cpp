@@ -0,0 +1,117 @@
+#include "Realtime.hpp"
+#include "System.hpp" // LINUX, WINDOWS
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#if LINUX
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t PREFAULT_STACK_BYTES = 256 * 1024;
+
+} // namespace
+
+RealtimeStatus configureRealtimeThread(int priority, int cpu) {
+    RealtimeStatus status;
+
+#if LINUX
+    sched_param param{};
+    param.sched_priority = priority;
+    status.schedError = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        status.affinityError = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    (void) priority;
+    status.schedError = ENOSYS;
+    if (cpu >= 0) status.affinityError = ENOSYS;
+#endif
+
+    return status;
+}
+
+bool reportRealtimeThread(const char* name, int priority, int cpu, const RealtimeStatus& status) {
+    if (status.schedError) {
+        std::fprintf(stderr, "Realtime: %s thread keeps normal scheduling, SCHED_FIFO %d failed: %s\n",
+                     name, priority, std::strerror(status.schedError));
+    }
+    if (status.affinityError) {
+        std::fprintf(stderr, "Realtime: cannot pin %s thread to CPU %d: %s\n",
+                     name, cpu, std::strerror(status.affinityError));
+    }
+
+    bool ok = !status.schedError && !status.affinityError;
+    if (ok) {
+        std::printf("Realtime: %s thread SCHED_FIFO %d%s\n", name, priority, cpu >= 0 ? ", pinned" : "");
+    }
+    return ok;
+}
+
+bool lockAllMemory() {
+#if LINUX
+    int flags = MCL_CURRENT | MCL_FUTURE;
+
+    // Root bypasses the limit, everyone else would see allocations fail once it is reached
+    rlimit limit{};
+    if (::geteuid() != 0 && ::getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        std::fprintf(stderr, "Realtime: RLIMIT_MEMLOCK is %llu KB, locking current memory only, "
+                             "samples loaded later may be paged out\n",
+                     static_cast<unsigned long long>(limit.rlim_cur >> 10));
+        flags = MCL_CURRENT;
+    }
+
+    if (::mlockall(flags) < 0) {
+        std::fprintf(stderr, "Realtime: mlockall failed, memory may be paged out: %s\n", std::strerror(errno));
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void prefaultMemory(const void* data, size_t bytes) {
+    if (!data || !bytes) return;
+
+#if LINUX
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#else
+    constexpr size_t page = 4096;
+#endif
+
+    const volatile uint8_t* p = static_cast<const volatile uint8_t*>(data);
+    for (size_t i = 0; i < bytes; i += page) (void) p[i];
+    (void) p[bytes - 1];
+}
+
+void prefaultStack() {
+    volatile uint8_t stack[PREFAULT_STACK_BYTES];
+    for (size_t i = 0; i < sizeof(stack); i += 4096) stack[i] = 0;
+}
+
+void enableDenormalFlush() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_setcsr(_mm_getcsr() | 0x8040); // FTZ | DAZ
+#elif defined(__aarch64__)
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    asm volatile("msr fpcr, %0" : : "r"(fpcr | (1ull << 24)));
+#endif
+}
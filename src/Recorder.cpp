@@ -0,0 +1,139 @@
+#include "Recorder.hpp"
+#include "Realtime.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+size_t ringSamples(float sampleRate) {
+    return std::bit_ceil(static_cast<size_t>(sampleRate * cfg::RECORD_RING_SECONDS) * 2);
+}
+
+} // namespace
+
+Recorder::Recorder(float sampleRate)
+    : sampleRate_(sampleRate),
+      ring_(ringSamples(sampleRate), 0.f),
+      mask_(ring_.size() - 1),
+      writePos_(0),
+      readPos_(0),
+      overruns_(0),
+      armed_(false),
+      file_(nullptr),
+      running_(false)
+{
+}
+
+Recorder::~Recorder() {
+    stop();
+}
+
+bool Recorder::start(const std::string& path) {
+    stop();
+
+    SF_INFO sfinfo{};
+    sfinfo.samplerate = static_cast<int>(sampleRate_);
+    sfinfo.channels = 2;
+    sfinfo.format = path.ends_with(".flac") ? (SF_FORMAT_FLAC | SF_FORMAT_PCM_24)
+                                            : (SF_FORMAT_WAV | SF_FORMAT_FLOAT);
+
+    file_ = sf_open(path.c_str(), SFM_WRITE, &sfinfo);
+    if (!file_) {
+        std::fprintf(stderr, "Failed to open recording %s: %s\n", path.c_str(), sf_strerror(nullptr));
+        return false;
+    }
+
+    // Integer formats would otherwise wrap samples beyond full scale around
+    sf_command(file_, SFC_SET_CLIPPING, nullptr, SF_TRUE);
+
+    path_ = path;
+    overruns_.store(0);
+
+    // Whatever the audio thread pushed after the last stop is stale
+    readPos_.store(writePos_.load(std::memory_order_acquire), std::memory_order_release);
+
+    running_.store(true);
+    thread_ = std::thread([this]() { run(); });
+    armed_.store(true, std::memory_order_release);
+
+    std::printf("Recording to %s\n", path.c_str());
+    return true;
+}
+
+void Recorder::stop() {
+    if (!running_.load()) return;
+
+    armed_.store(false, std::memory_order_release);
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+
+    sf_close(file_);
+    file_ = nullptr;
+
+    std::printf("Stopped recording %s", path_.c_str());
+    if (uint64_t dropped = overruns_.load()) std::printf(", %llu frames dropped", static_cast<unsigned long long>(dropped));
+    std::printf("\n");
+}
+
+void Recorder::prefault() const {
+    prefaultMemory(ring_.data(), ring_.size() * sizeof(float));
+}
+
+void Recorder::push(const float* data, unsigned long frames) {
+    if (!armed_.load(std::memory_order_acquire)) return;
+
+    const size_t samples = frames * 2;
+    const size_t write = writePos_.load(std::memory_order_relaxed);
+    const size_t read = readPos_.load(std::memory_order_acquire);
+
+    if (ring_.size() - (write - read) < samples) {
+        overruns_.fetch_add(frames, std::memory_order_relaxed);
+        return;
+    }
+
+    const size_t start = write & mask_;
+    const size_t first = std::min(samples, ring_.size() - start);
+    std::copy_n(data, first, ring_.data() + start);
+    std::copy_n(data + first, samples - first, ring_.data());
+
+    writePos_.store(write + samples, std::memory_order_release);
+}
+
+size_t Recorder::drain() {
+    const size_t read = readPos_.load(std::memory_order_relaxed);
+    const size_t write = writePos_.load(std::memory_order_acquire);
+    const size_t available = write - read;
+    if (available == 0) return 0;
+
+    // At most two contiguous runs, each written in one call
+    const size_t start = read & mask_;
+    const size_t first = std::min(available, ring_.size() - start);
+    sf_writef_float(file_, ring_.data() + start, static_cast<sf_count_t>(first / 2));
+    if (available > first) {
+        sf_writef_float(file_, ring_.data(), static_cast<sf_count_t>((available - first) / 2));
+    }
+
+    readPos_.store(write, std::memory_order_release);
+    return available;
+}
+
+void Recorder::run() {
+    uint64_t reported = 0;
+
+    while (running_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cfg::RECORD_DRAIN_MS));
+        drain();
+
+        uint64_t dropped = overruns_.load(std::memory_order_relaxed);
+        if (dropped != reported) {
+            std::fprintf(stderr, "Recorder: disk fell behind, %llu frames dropped\n",
+                         static_cast<unsigned long long>(dropped));
+            reported = dropped;
+        }
+    }
+
+    drain();
+}
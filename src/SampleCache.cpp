@@ -0,0 +1,113 @@
+#include "SampleCache.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// FNV-1a over the raw file bytes
+bool hashFile(const char* path, uint64_t& hash, uint64_t& size) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    hash = 0xcbf29ce484222325ull;
+    size = 0;
+
+    std::vector<char> buffer(1 << 16);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize n = file.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash ^= static_cast<uint8_t>(buffer[i]);
+            hash *= 0x100000001b3ull;
+        }
+        size += static_cast<uint64_t>(n);
+    }
+
+    return true;
+}
+
+} // namespace
+
+SampleCache::SampleCache(size_t budgetBytes)
+    : budget_(budgetBytes), resident_(0)
+{
+}
+
+std::shared_ptr<const SampleData> SampleCache::load(const char* path, SampleStorage storage, bool& reused) {
+    reused = false;
+
+    uint64_t hash, size;
+    if (!hashFile(path, hash, size)) {
+        std::fprintf(stderr, "Failed to open sample: %s\n", path);
+        return nullptr;
+    }
+
+    Key key{ hash, size, storage };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            reused = true;
+            return it->second.data;
+        }
+    }
+
+    // Decoding happens outside the lock, it is by far the slowest part
+    auto data = SampleData::load(path, storage);
+    if (!data) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto [it, inserted] = entries_.try_emplace(key);
+    if (!inserted) {
+        // Someone decoded the same data meanwhile, share theirs
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        reused = true;
+        return it->second.data;
+    }
+
+    lru_.push_front(key);
+    it->second.data = data;
+    it->second.bytes = data->bytes();
+    it->second.lru = lru_.begin();
+    resident_ += it->second.bytes;
+
+    evict();
+
+    return data;
+}
+
+void SampleCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = budgetBytes;
+    evict();
+}
+
+size_t SampleCache::budgetBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_;
+}
+
+size_t SampleCache::residentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_;
+}
+
+void SampleCache::evict() {
+    // Entries still referenced by a slot or a sounding voice stay, dropping them frees nothing
+    for (auto key = lru_.rbegin(); key != lru_.rend() && resident_ > budget_;) {
+        auto it = entries_.find(*key);
+        if (it->second.data.use_count() > 1) {
+            ++key;
+            continue;
+        }
+
+        resident_ -= it->second.bytes;
+        entries_.erase(it);
+        key = std::make_reverse_iterator(lru_.erase(std::next(key).base()));
+    }
+}
@@ -0,0 +1,297 @@
+#include "SampleData.hpp"
+
+#include <sndfile.h>
+
+#include "Config.hpp"
+#include "Kaiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <immintrin.h>
+    #define SAMPLE_X86 1
+#else
+    #define SAMPLE_X86 0
+#endif
+
+namespace {
+
+constexpr float INT16_SCALE = 1.f / 32768.f;
+constexpr float INT32_SCALE = 1.f / 2147483648.f;
+
+void decodeInt16Impl(const int16_t* src, size_t count, float* dst) {
+    size_t i = 0;
+#if SAMPLE_X86 && defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(INT16_SCALE);
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // Widen to 32 bits by placing each value in the high half and shifting back with sign
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#endif
+    for (; i < count; ++i) dst[i] = src[i] * INT16_SCALE;
+}
+
+inline int32_t loadInt24(const uint8_t* p) {
+    return static_cast<int32_t>((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24));
+}
+
+void decodeInt24Scalar(const uint8_t* src, size_t count, float* dst) {
+    for (size_t i = 0; i < count; ++i) dst[i] = loadInt24(src + i * 3) * INT32_SCALE;
+}
+
+#if SAMPLE_X86 && defined(__GNUC__)
+__attribute__((target("ssse3")))
+void decodeInt24Ssse3(const uint8_t* src, size_t count, float* dst) {
+    const __m128 scale = _mm_set1_ps(INT32_SCALE);
+    // Move each 3-byte frame into the top of a 32-bit lane, leaving a left-justified int32
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+
+    size_t i = 0;
+    // Each load reads 16 bytes but consumes 12, so stop while 4 spare bytes remain
+    for (; i + 6 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        __m128i v = _mm_shuffle_epi8(x, shuffle);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+    }
+    decodeInt24Scalar(src + i * 3, count - i, dst + i);
+}
+#endif
+
+using decode24_t = void (*)(const uint8_t*, size_t, float*);
+
+decode24_t selectDecodeInt24() {
+#if SAMPLE_X86 && defined(__GNUC__)
+    if (__builtin_cpu_supports("ssse3")) return &decodeInt24Ssse3;
+#endif
+    return &decodeInt24Scalar;
+}
+
+const decode24_t decodeInt24Impl = selectDecodeInt24();
+
+// Windowed-sinc lowpass at a quarter of the rate, leaving headroom below the new Nyquist
+std::vector<float> halfbandFilter() {
+    constexpr int center = cfg::MIP_FILTER_TAPS / 2;
+    constexpr double cutoff = 0.225;
+    constexpr double beta = 8.0;
+
+    std::vector<float> taps(cfg::MIP_FILTER_TAPS);
+    double sum = 0.0;
+    for (int n = 0; n < cfg::MIP_FILTER_TAPS; ++n) {
+        double x = n - center;
+        double t = x / center;
+        double arg = 2.0 * M_PI * cutoff * x;
+        double h = 2.0 * cutoff * (x == 0.0 ? 1.0 : std::sin(arg) / arg) * kaiserWindow(t, beta);
+        taps[n] = static_cast<float>(h);
+        sum += h;
+    }
+    for (auto& h : taps) h = static_cast<float>(h / sum);
+
+    return taps;
+}
+
+void encode(SampleData& sample, const std::vector<float>& data) {
+    switch (sample.format) {
+        case SampleFormat::Float32:
+            sample.f32 = data;
+            break;
+        case SampleFormat::Int16:
+            sample.i16.resize(data.size());
+            for (size_t i = 0; i < data.size(); ++i) {
+                sample.i16[i] = static_cast<int16_t>(std::lrint(std::clamp(data[i] * 32768.f, -32768.f, 32767.f)));
+            }
+            break;
+        case SampleFormat::Int24:
+            sample.i24.resize(data.size() * 3);
+            for (size_t i = 0; i < data.size(); ++i) {
+                int32_t v = static_cast<int32_t>(std::lrint(std::clamp(data[i] * 8388608.f, -8388608.f, 8388607.f)));
+                sample.i24[i * 3 + 0] = static_cast<uint8_t>(v);
+                sample.i24[i * 3 + 1] = static_cast<uint8_t>(v >> 8);
+                sample.i24[i * 3 + 2] = static_cast<uint8_t>(v >> 16);
+            }
+            break;
+    }
+}
+
+// Each level is filtered and decimated from the previous one, so the whole pyramid
+// adds less than one extra copy of the original
+void buildLevels(SampleData& sample) {
+    static const std::vector<float> taps = halfbandFilter();
+    constexpr ptrdiff_t center = cfg::MIP_FILTER_TAPS / 2;
+
+    const size_t channels = static_cast<size_t>(sample.channels);
+    std::vector<float> src(sample.frames * channels);
+    sample.decode(0, sample.frames, src.data());
+
+    sample.levels.reserve(cfg::MIP_MAX_LEVELS);
+    const SampleData* prev = &sample;
+
+    for (int level = 0; level < cfg::MIP_MAX_LEVELS && prev->frames / 2 >= cfg::MIP_MIN_FRAMES; ++level) {
+        SampleData next;
+        next.format = sample.format;
+        next.rate = prev->rate / 2;
+        next.channels = sample.channels;
+        next.frames = prev->frames / 2;
+
+        std::vector<float> dst(next.frames * channels);
+        const ptrdiff_t srcFrames = static_cast<ptrdiff_t>(prev->frames);
+
+        for (size_t m = 0; m < next.frames; ++m) {
+            for (size_t c = 0; c < channels; ++c) {
+                float acc = 0.f;
+                for (ptrdiff_t k = 0; k < cfg::MIP_FILTER_TAPS; ++k) {
+                    ptrdiff_t i = static_cast<ptrdiff_t>(m * 2) + k - center;
+                    if (i >= 0 && i < srcFrames) acc += taps[k] * src[i * channels + c];
+                }
+                dst[m * channels + c] = acc;
+            }
+        }
+
+        encode(next, dst);
+        src = std::move(dst);
+
+        sample.levels.push_back(std::move(next));
+        prev = &sample.levels.back();
+    }
+}
+
+} // namespace
+
+void decodeInt16(const int16_t* src, size_t count, float* dst) {
+    decodeInt16Impl(src, count, dst);
+}
+
+void decodeInt24(const uint8_t* src, size_t count, float* dst) {
+    decodeInt24Impl(src, count, dst);
+}
+
+const char* sampleFormatName(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Float32: return "float32";
+        case SampleFormat::Int16: return "int16";
+        case SampleFormat::Int24: return "int24";
+    }
+    return "unknown";
+}
+
+size_t SampleData::bytes() const {
+    size_t total = f32.size() * sizeof(float) + i16.size() * sizeof(int16_t) + i24.size();
+    for (const auto& level : levels) total += level.bytes();
+    return total;
+}
+
+const SampleData& SampleData::levelFor(float& step) const {
+    const SampleData* level = this;
+    for (const auto& next : levels) {
+        if (step <= cfg::MIP_MAX_STEP) break;
+        level = &next;
+        step *= 0.5f;
+    }
+    return *level;
+}
+
+void SampleData::decode(size_t first, size_t count, float* dst) const {
+    first *= channels;
+    count *= channels;
+
+    switch (format) {
+        case SampleFormat::Float32:
+            std::memcpy(dst, f32.data() + first, count * sizeof(float));
+            break;
+        case SampleFormat::Int16:
+            decodeInt16(i16.data() + first, count, dst);
+            break;
+        case SampleFormat::Int24:
+            decodeInt24(i24.data() + first * 3, count, dst);
+            break;
+    }
+}
+
+std::shared_ptr<const SampleData> SampleData::load(const char* path, SampleStorage storage) {
+    SF_INFO sfinfo{};
+    SNDFILE* sndfile = sf_open(path, SFM_READ, &sfinfo);
+    if (!sndfile) {
+        std::cerr << "Failed to open sample: " << path << "\n";
+        return nullptr;
+    }
+
+    auto sample = std::make_shared<SampleData>();
+    sample->rate = sfinfo.samplerate;
+    sample->frames = static_cast<size_t>(sfinfo.frames);
+
+    // Mono and stereo are kept as they are, anything wider is mixed down to mono
+    size_t channels = static_cast<size_t>(sfinfo.channels);
+    size_t samples = sample->frames * channels;
+    size_t kept = channels <= 2 ? channels : 1;
+    size_t fold = channels / kept;
+    sample->channels = static_cast<int>(kept);
+
+    sample->format = SampleFormat::Float32;
+    if (storage == SampleStorage::Native) {
+        switch (sfinfo.format & SF_FORMAT_SUBMASK) {
+            case SF_FORMAT_PCM_S8:
+            case SF_FORMAT_PCM_U8:
+            case SF_FORMAT_PCM_16:
+                sample->format = SampleFormat::Int16;
+                break;
+            case SF_FORMAT_PCM_24:
+                sample->format = SampleFormat::Int24;
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t out = sample->frames * kept;
+
+    switch (sample->format) {
+        case SampleFormat::Float32: {
+            std::vector<float> data(samples);
+            sf_read_float(sndfile, data.data(), static_cast<sf_count_t>(samples));
+
+            sample->f32.resize(out);
+            for (size_t i = 0; i < out; ++i) {
+                float sum = 0.f;
+                for (size_t c = 0; c < fold; ++c) sum += data[i * fold + c];
+                sample->f32[i] = sum / fold;
+            }
+        } break;
+        case SampleFormat::Int16: {
+            std::vector<short> data(samples);
+            sf_read_short(sndfile, data.data(), static_cast<sf_count_t>(samples));
+
+            sample->i16.resize(out);
+            for (size_t i = 0; i < out; ++i) {
+                int32_t sum = 0;
+                for (size_t c = 0; c < fold; ++c) sum += data[i * fold + c];
+                sample->i16[i] = static_cast<int16_t>(sum / static_cast<int32_t>(fold));
+            }
+        } break;
+        case SampleFormat::Int24: {
+            std::vector<int> data(samples);
+            sf_read_int(sndfile, data.data(), static_cast<sf_count_t>(samples));
+
+            sample->i24.resize(out * 3);
+            for (size_t i = 0; i < out; ++i) {
+                int64_t sum = 0;
+                for (size_t c = 0; c < fold; ++c) sum += data[i * fold + c];
+                uint32_t v = static_cast<uint32_t>(static_cast<int32_t>(sum / static_cast<int64_t>(fold)));
+                sample->i24[i * 3 + 0] = static_cast<uint8_t>(v >> 8);
+                sample->i24[i * 3 + 1] = static_cast<uint8_t>(v >> 16);
+                sample->i24[i * 3 + 2] = static_cast<uint8_t>(v >> 24);
+            }
+        } break;
+    }
+
+    sf_close(sndfile);
+
+    buildLevels(*sample);
+
+    return sample;
+}
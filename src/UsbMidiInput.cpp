@@ -0,0 +1,54 @@
+#include "MidiInput.hpp"
+#include "Config.hpp"
+
+#include <cstdio>
+
+UsbMidiInput::UsbMidiInput(const std::string& device, const std::string& capturePath)
+    : usb_(device.c_str())
+{
+    if (!capturePath.empty()) capture_ = std::make_unique<MidiLogWriter>(capturePath);
+}
+
+void UsbMidiInput::decodePacket(const uint8_t* data, size_t count, std::vector<MidiEvent>& events) {
+    for (size_t i = 0; i + 4 <= count; i += 4) {
+        const uint8_t* group = data + i;
+        if (group[0] == 0) continue; // unused groups at the end of a packet
+
+        // High nibble is the cable, low nibble the code index, then the MIDI message itself
+        uint8_t cable = group[0] >> 4;
+        MidiEvent event;
+        if (decodeMidiMessage(group[1], group[2], group[3], cable == cfg::USB_PAD_CABLE, event)) {
+            events.push_back(event);
+        } else {
+            std::printf("%02x %02x %02x %02x\n", group[0], group[1], group[2], group[3]);
+        }
+    }
+}
+
+void UsbMidiInput::run(callback_t callback) {
+    usb_.start([&](uint8_t address, uint8_t* data, uint8_t count) {
+        if (capture_) capture_->write(address, data, count);
+
+        events_.clear();
+        decodePacket(data, count, events_);
+        if (!events_.empty()) callback(events_.data(), events_.size());
+    });
+}
+
+ReplayMidiInput::ReplayMidiInput(const std::string& path, bool realtime, MidiLogPlayer::wait_t clock)
+    : player_(path),
+      realtime_(realtime),
+      clock_(std::move(clock))
+{
+}
+
+void ReplayMidiInput::run(callback_t callback) {
+    auto dispatch = [&](uint8_t, uint8_t* data, uint8_t count) {
+        events_.clear();
+        UsbMidiInput::decodePacket(data, count, events_);
+        if (!events_.empty()) callback(events_.data(), events_.size());
+    };
+
+    if (clock_) player_.runPaced(dispatch, clock_);
+    else player_.run(dispatch, realtime_);
+}
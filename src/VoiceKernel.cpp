@@ -0,0 +1,262 @@
+#include "VoiceKernel.hpp"
+#include "Config.hpp"
+#include "Kaiser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+    #include <immintrin.h>
+    #define KERNEL_SSE 1
+#else
+    #define KERNEL_SSE 0
+#endif
+
+namespace {
+
+static_assert(cfg::SINC_TAPS % 4 == 0 && cfg::SINC_TAPS >= 8 && cfg::SINC_TAPS <= 32,
+              "SINC_TAPS must be a multiple of 4 between 8 and 32");
+
+// One row of SINC_TAPS coefficients per fractional phase, plus a closing row so
+// that the coefficients can be interpolated between neighbouring phases
+struct SincTable {
+    alignas(16) float coeffs[cfg::SINC_PHASES + 1][cfg::SINC_TAPS];
+
+    explicit SincTable(double cutoff);
+};
+
+constexpr size_t SINC_TABLES = std::size(cfg::SINC_TABLE_STEPS);
+
+SincTable::SincTable(double cutoff) {
+    constexpr int half = cfg::SINC_TAPS / 2;
+
+    for (int p = 0; p <= cfg::SINC_PHASES; ++p) {
+        double frac = static_cast<double>(p) / cfg::SINC_PHASES;
+        double sum = 0.0;
+        double row[cfg::SINC_TAPS];
+
+        for (int j = 0; j < cfg::SINC_TAPS; ++j) {
+            double x = (j - (half - 1)) - frac;
+            double t = x / half;
+            double window = kaiserWindow(t, cfg::SINC_KAISER_BETA);
+            double arg = M_PI * cutoff * x;
+            double sinc = arg == 0.0 ? 1.0 : std::sin(arg) / arg;
+            row[j] = cutoff * sinc * window;
+            sum += row[j];
+        }
+
+        // Unity gain at DC for every phase
+        for (int j = 0; j < cfg::SINC_TAPS; ++j) coeffs[p][j] = static_cast<float>(row[j] / sum);
+    }
+}
+
+template <size_t... I>
+std::array<SincTable, SINC_TABLES> makeSincTables(std::index_sequence<I...>) {
+    return { SincTable(cfg::SINC_CUTOFF / std::max(1.f, cfg::SINC_TABLE_STEPS[I]))... };
+}
+
+const std::array<SincTable, SINC_TABLES> sincTables = makeSincTables(std::make_index_sequence<SINC_TABLES>());
+
+const SincTable& sincTableFor(double step) {
+    for (size_t i = 0; i < SINC_TABLES; ++i) {
+        if (step <= cfg::SINC_TABLE_STEPS[i]) return sincTables[i];
+    }
+    return sincTables[SINC_TABLES - 1];
+}
+
+template <Interpolation I> struct Interp;
+
+template <> struct Interp<Interpolation::Linear> {
+    // Frames read before and after the integer position
+    static constexpr size_t before = 0;
+    static constexpr size_t after = 1;
+
+    static const SincTable* table(double) { return nullptr; }
+
+    template <int C>
+    static void read(const float* p, float frac, const SincTable*, float& left, float& right) {
+        if constexpr (C == 1) {
+            left = right = p[0] + (p[1] - p[0]) * frac;
+        } else {
+            left = p[0] + (p[2] - p[0]) * frac;
+            right = p[1] + (p[3] - p[1]) * frac;
+        }
+    }
+};
+
+template <> struct Interp<Interpolation::Sinc> {
+    static constexpr size_t before = cfg::SINC_TAPS / 2 - 1;
+    static constexpr size_t after = cfg::SINC_TAPS / 2;
+
+    // Chosen once per block from the fastest step in it
+    static const SincTable* table(double maxStep) { return &sincTableFor(maxStep); }
+
+    template <int C>
+    static void read(const float* p, float frac, const SincTable* table, float& left, float& right) {
+        p -= before * C;
+
+        float phase = frac * cfg::SINC_PHASES;
+        int row = std::min(static_cast<int>(phase), cfg::SINC_PHASES - 1);
+        float t = phase - row;
+        const float* c0 = table->coeffs[row];
+        const float* c1 = table->coeffs[row + 1];
+
+#if KERNEL_SSE
+        const __m128 vt = _mm_set1_ps(t);
+        __m128 acc = _mm_setzero_ps();
+
+        for (int j = 0; j < cfg::SINC_TAPS; j += 4) {
+            __m128 a = _mm_load_ps(c0 + j);
+            __m128 c = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(c1 + j), a), vt));
+
+            if constexpr (C == 1) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_loadu_ps(p + j)));
+            } else {
+                // Two interleaved frames per load, each coefficient used for both channels
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpacklo_ps(c, c), _mm_loadu_ps(p + j * 2)));
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpackhi_ps(c, c), _mm_loadu_ps(p + j * 2 + 4)));
+            }
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, acc);
+
+        if constexpr (C == 1) {
+            left = right = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        } else {
+            left = lanes[0] + lanes[2];
+            right = lanes[1] + lanes[3];
+        }
+#else
+        float l = 0.f, r = 0.f;
+        for (int j = 0; j < cfg::SINC_TAPS; ++j) {
+            float c = c0[j] + (c1[j] - c0[j]) * t;
+            l += c * p[j * C];
+            if constexpr (C == 2) r += c * p[j * 2 + 1];
+        }
+        left = l;
+        right = C == 1 ? l : r;
+#endif
+    }
+};
+
+template <SampleFormat F, int C>
+void decodeSpan(const SampleData& sample, size_t first, size_t count, float* dst) {
+    if constexpr (F == SampleFormat::Float32) {
+        std::memcpy(dst, sample.f32.data() + first * C, count * C * sizeof(float));
+    } else if constexpr (F == SampleFormat::Int16) {
+        decodeInt16(sample.i16.data() + first * C, count * C, dst);
+    } else {
+        decodeInt24(sample.i24.data() + first * C * 3, count * C, dst);
+    }
+}
+
+template <Interpolation I, int C, SampleFormat F, bool Modulated>
+bool render(const SampleData& sample, double& pos, float stepFrom, float stepTo,
+            float gain, float* mix, size_t frames, float* scratch)
+{
+    using In = Interp<I>;
+
+    const double maxStep = std::max(stepFrom, stepTo);
+    const double dstep = Modulated ? (static_cast<double>(stepTo) - stepFrom) / frames : 0.0;
+    double step = Modulated ? stepFrom : stepTo;
+    const SincTable* table = In::table(maxStep);
+
+    size_t done = 0;
+
+    while (done < frames) {
+        size_t first = static_cast<size_t>(pos);
+        if (first + In::after >= sample.frames) return false;
+
+        // Integer samples are converted a span at a time and float samples are read in place.
+        // Spans hold In::before frames ahead of the position, zero where that precedes the sample.
+        const float* src;
+        ptrdiff_t base;
+        size_t end;
+
+        if (F == SampleFormat::Float32 && first >= In::before) {
+            src = sample.f32.data();
+            base = 0;
+            end = sample.frames;
+        } else {
+            size_t lead = std::min(first, In::before);
+            size_t zeros = In::before - lead;
+            size_t needed = static_cast<size_t>((frames - done) * maxStep) + In::after + 2;
+            size_t count = std::min({ needed + lead, sample.frames - (first - lead),
+                                      static_cast<size_t>(cfg::DECODE_FRAMES / C) - zeros });
+
+            std::fill_n(scratch, zeros * C, 0.f);
+            decodeSpan<F, C>(sample, first - lead, count, scratch + zeros * C);
+
+            src = scratch;
+            base = static_cast<ptrdiff_t>(first) - static_cast<ptrdiff_t>(In::before);
+            end = first - lead + count;
+        }
+
+        // Frames that provably stay inside the span, so the loop below needs no checks.
+        // The current position is always readable, so at least one frame makes progress.
+        double room = (static_cast<double>(end - In::after) - pos) / maxStep;
+        size_t n = std::min(frames - done, std::max<size_t>(1, static_cast<size_t>(room)));
+
+        float* out = mix + done * 2;
+        for (size_t k = 0; k < n; ++k) {
+            size_t ipos = static_cast<size_t>(pos);
+            float frac = static_cast<float>(pos - ipos);
+
+            float left, right;
+            In::template read<C>(src + (static_cast<ptrdiff_t>(ipos) - base) * C, frac, table, left, right);
+            out[k * 2] += left * gain;
+            out[k * 2 + 1] += right * gain;
+
+            pos += step;
+            if constexpr (Modulated) step += dstep;
+        }
+
+        done += n;
+    }
+
+    return true;
+}
+
+template <Interpolation I, int C, SampleFormat F>
+constexpr VoiceKernel kernelFor() {
+    return { &render<I, C, F, false>, &render<I, C, F, true> };
+}
+
+template <Interpolation I, int C>
+constexpr std::array<VoiceKernel, 3> kernelsForChannels() {
+    return { kernelFor<I, C, SampleFormat::Float32>(),
+             kernelFor<I, C, SampleFormat::Int16>(),
+             kernelFor<I, C, SampleFormat::Int24>() };
+}
+
+template <Interpolation I>
+constexpr std::array<std::array<VoiceKernel, 3>, 2> kernelsForInterp() {
+    return { kernelsForChannels<I, 1>(), kernelsForChannels<I, 2>() };
+}
+
+// Indexed by interpolation, channel count - 1 and storage format
+constexpr std::array<std::array<std::array<VoiceKernel, 3>, 2>, 2> KERNELS = {
+    kernelsForInterp<Interpolation::Linear>(),
+    kernelsForInterp<Interpolation::Sinc>(),
+};
+
+} // namespace
+
+const char* interpolationName(Interpolation interp) {
+    switch (interp) {
+        case Interpolation::Linear: return "linear";
+        case Interpolation::Sinc: return "sinc";
+    }
+    return "unknown";
+}
+
+const VoiceKernel& selectVoiceKernel(Interpolation interp, const SampleData& sample) {
+    return KERNELS[static_cast<size_t>(interp)]
+                  [static_cast<size_t>(sample.channels - 1)]
+                  [static_cast<size_t>(sample.format)];
+}
@@ -1,81 +1,238 @@
 #include "Config.hpp"
 #include "Audio.hpp"
 #include "Graphics.hpp"
-#include "USB.hpp"
+#include "MidiInput.hpp"
+#include "LatencyTuner.hpp"
+#include "Benchmark.hpp"
 
+#include <algorithm>
 #include <thread>
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+static int usage(const char* prog) {
+    std::fprintf(stderr,
+                 "Usage: %s [--storage=float|native] [--output=portaudio|alsa[:device]|null|wav:<path>]\n"
+                 "       [--rate=<hz>] [--frames=<n>] [--tune-latency] [--record=<path>]\n"
+                 "       [--interp=[piano:|pad<n>:]linear|sinc]... [--cache-mb=<n>] [--fx=<effect>,...|none]\n"
+                 "       [--realtime] [--audio-cpu=<n>] [--input-cpu=<n>] [--capture-midi=<path>] [--replay-fast]\n"
+                 "       [--sample=[piano:|pad<n>:]<path>]...\n"
+                 "       <usb-device> | --input=usb:<device>|seq[:<client>:<port>]|rawmidi[:<device>]|replay:<path>\n"
+                 "       %s --headless --input=replay:<path> --output=null|wav:<path> [--sample=...]... [options]\n"
+                 "       %s --bench [--rate=<hz>]\n",
+                 prog, prog, prog);
+    return 1;
+}
+
+// Strips a "piano:" or "pad<n>:" prefix, instrument is the pad index, NUM_PERC for the
+// piano or -1 without a prefix
+static bool parseInstrument(std::string_view& arg, int& instrument) {
+    instrument = -1;
+
+    size_t colon = arg.find(':');
+    if (colon == std::string_view::npos) return true;
+
+    std::string_view target = arg.substr(0, colon);
+    if (target == "piano") instrument = cfg::NUM_PERC;
+    else if (target.size() == 4 && target.starts_with("pad") && target[3] >= '0' && target[3] < '0' + cfg::NUM_PERC) {
+        instrument = target[3] - '0';
+    } else return false;
+
+    arg = arg.substr(colon + 1);
+    return true;
+}
+
+// "[piano:|pad<n>:]linear|sinc", without a prefix it applies to every instrument
+static bool parseInterp(std::string_view arg, int& instrument, Interpolation& interp) {
+    if (!parseInstrument(arg, instrument)) return false;
+
+    if (arg == "linear") interp = Interpolation::Linear;
+    else if (arg == "sinc") interp = Interpolation::Sinc;
+    else return false;
+
+    return true;
+}
+
+// Replays the log on this thread, rendering into the sink until each packet's timestamp
+// before handing it over, so the same log always produces the same audio
+static void renderOffline(Audio& audio, NullOutput& sink, std::string_view inputSpec, InputConfig config) {
+    const double blockNs = sink.config().frames / sink.config().sampleRate * 1e9;
+    uint64_t blocks = 0;
+
+    auto renderUntil = [&](std::chrono::nanoseconds time) {
+        while (blocks * blockNs < time.count()) {
+            sink.step();
+            ++blocks;
+        }
+    };
+
+    std::chrono::nanoseconds last{0};
+    config.replayClock = [&](std::chrono::nanoseconds offset) {
+        renderUntil(offset);
+        last = offset;
+    };
+
+    auto input = MidiInput::create(inputSpec, config);
+    input->run([&](const MidiEvent* events, size_t count) {
+        audio.handleEvents(events, count);
+    });
+
+    renderUntil(last + std::chrono::seconds(cfg::HEADLESS_TAIL_SECONDS));
+    std::printf("Rendered %.3f s offline\n", blocks * blockNs / 1e9);
+}
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::fprintf(stderr, "Usage: %s <usb-device>\n", argv[0]);
-        return 1;
+    std::string inputSpec;
+    InputConfig inputConfig;
+    SampleStorage storage = SampleStorage::Float;
+    std::string_view output = "portaudio";
+    StreamConfig stream;
+    bool tune = false;
+    const char* recordPath = nullptr;
+    bool bench = false;
+    size_t cacheMb = cfg::SAMPLE_CACHE_MB;
+    RealtimeConfig realtime;
+    std::vector<std::pair<int, Interpolation>> interps;
+    std::string_view fx = "limiter";
+    std::vector<std::pair<int, std::string>> samples;
+    bool headless = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+
+        if (arg == "--storage=float") storage = SampleStorage::Float;
+        else if (arg == "--storage=native") storage = SampleStorage::Native;
+        else if (arg.starts_with("--output=")) output = arg.substr(9);
+        else if (arg.starts_with("--rate=")) stream.sampleRate = std::strtof(argv[i] + 7, nullptr);
+        else if (arg.starts_with("--frames=")) stream.frames = std::strtoul(argv[i] + 9, nullptr, 10);
+        else if (arg == "--tune-latency") tune = true;
+        else if (arg.starts_with("--record=")) recordPath = argv[i] + 9;
+        else if (arg == "--bench") bench = true;
+        else if (arg.starts_with("--cache-mb=")) cacheMb = std::strtoul(argv[i] + 11, nullptr, 10);
+        else if (arg.starts_with("--fx=")) fx = arg.substr(5);
+        else if (arg == "--realtime") realtime.enabled = true;
+        else if (arg.starts_with("--audio-cpu=")) realtime.audioCpu = std::atoi(argv[i] + 12);
+        else if (arg.starts_with("--input-cpu=")) realtime.inputCpu = std::atoi(argv[i] + 12);
+        else if (arg.starts_with("--capture-midi=")) inputConfig.capturePath = arg.substr(15);
+        else if (arg == "--replay-fast") inputConfig.replayFast = true;
+        else if (arg == "--headless") headless = true;
+        else if (arg.starts_with("--sample=")) {
+            std::string_view path = arg.substr(9);
+            int instrument;
+            if (!parseInstrument(path, instrument) || instrument < 0 || path.empty()) return usage(argv[0]);
+            samples.emplace_back(instrument, std::string(path));
+        }
+        else if (arg.starts_with("--input=")) {
+            if (!inputSpec.empty()) return usage(argv[0]);
+            inputSpec = arg.substr(8);
+        }
+        else if (arg.starts_with("--interp=")) {
+            int instrument;
+            Interpolation interp;
+            if (!parseInterp(arg.substr(9), instrument, interp)) return usage(argv[0]);
+            interps.emplace_back(instrument, interp);
+        }
+        // A bare device path is the raw USB input
+        else if (arg.starts_with("-") || !inputSpec.empty()) return usage(argv[0]);
+        else inputSpec = "usb:" + std::string(arg);
+    }
+
+    if (bench) return runBenchmark(stream.sampleRate);
+
+    if (inputSpec.empty() || stream.sampleRate <= 0.f || stream.frames == 0) return usage(argv[0]);
+
+    // Headless renders a replay as fast as it can, which only the file and null sinks can take.
+    // --record would drop blocks doing that, the wav output is the recording.
+    if (headless && (!inputSpec.starts_with("replay:") || !(output == "null" || output.starts_with("wav:")) ||
+                     tune || recordPath)) {
+        return usage(argv[0]);
+    }
+    stream.offline = headless;
+
+    // Effects not named in --fx start bypassed
+    uint32_t bypass = (1u << EffectChain::NUM_EFFECTS) - 1;
+    for (size_t start = 0; fx != "none" && start <= fx.size();) {
+        size_t comma = std::min(fx.find(',', start), fx.size());
+        int idx = EffectChain::find(fx.substr(start, comma - start));
+        if (idx < 0) return usage(argv[0]);
+        bypass &= ~(1u << idx);
+        start = comma + 1;
     }
 
     try {
-        Audio audio;
+        auto sink = Output::create(output, stream);
+        NullOutput* offline = headless ? dynamic_cast<NullOutput*>(sink.get()) : nullptr;
+
+        Audio audio(std::move(sink), stream.sampleRate, realtime, bypass);
+        audio.setSampleStorage(storage);
+        audio.sampleCache().setBudget(cacheMb << 20);
+
+        for (auto [instrument, interp] : interps) {
+            if (instrument < 0 || instrument == cfg::NUM_PERC) audio.setPianoInterpolation(interp);
+            for (int i = 0; i < cfg::NUM_PERC; ++i) {
+                if (instrument < 0 || instrument == i) audio.setPercInterpolation(static_cast<uint8_t>(i), interp);
+            }
+        }
+
+        for (const auto& [instrument, path] : samples) {
+            bool ok = instrument == cfg::NUM_PERC ? audio.loadSample(path.c_str())
+                                                  : audio.loadPercSample(static_cast<uint8_t>(instrument), path.c_str());
+            if (!ok) return 1;
+        }
+
+        if (offline) {
+            renderOffline(audio, *offline, inputSpec, inputConfig);
+            audio.effects().report();
+            return 0;
+        }
+
+        if (recordPath && !audio.recorder().start(recordPath)) return 1;
+
         Graphics gfx(audio);
 
-        USB usb(argv[1]);
-        std::thread usbThread([&]() {
-            usb.start([&](uint8_t, uint8_t* data, uint8_t count){
-                if (count < 4) return;
-
-                switch (data[0]) {
-                    case 0x08: // note off
-                        break;
-                    case 0x09: { // note on
-                        int key = data[2];
-                        int vel = data[3];
-                        if (vel > 0) {
-                            audio.noteOn(static_cast<uint8_t>(key), static_cast<uint8_t>(vel));
-                        }
-                    } break;
-                    case 0x0E: { // pitch
-                        audio.pitchBend(data[3]);
-                    } break;
-                    case 0x28: // percussion off
-                        break;
-                    case 0x29: { // percussion on
-                        uint8_t idx;
-
-                        switch (data[2]) {
-                            case 0x28: idx = 0; break;
-                            case 0x29: idx = 1; break;
-                            case 0x2a: idx = 2; break;
-                            case 0x2b: idx = 3; break;
-                            case 0x30: idx = 4; break;
-                            case 0x31: idx = 5; break;
-                            case 0x32: idx = 6; break;
-                            case 0x33: idx = 7; break;
-                            default: goto invalid;
-                        }
-
-                        audio.percOn(idx, data[3]);
-
-                        invalid:;
-                    } break;
-                    default:
-                        std::printf("%02x %02x %02x %02x\n", data[0], data[1], data[2], data[3]);
-                }
+        auto input = MidiInput::create(inputSpec, inputConfig);
+
+        std::thread inputThread([&]() {
+            if (realtime.enabled) {
+                reportRealtimeThread("input", cfg::RT_INPUT_PRIORITY, realtime.inputCpu,
+                                     configureRealtimeThread(cfg::RT_INPUT_PRIORITY, realtime.inputCpu));
+            }
+
+            input->run([&](const MidiEvent* events, size_t count) {
+                audio.handleEvents(events, count);
             });
         });
 
-        usbThread.detach();
+        inputThread.detach();
 
         std::thread decayThread([&]() {
             while (true) {
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
                 audio.decayKeysOnce();
                 audio.decayPercOnce();
+                audio.checkOutput();
             }
         });
 
         decayThread.detach();
 
+        // Joined before Audio goes away, since the tuner keeps replacing its output
+        LatencyTuner tuner(audio, std::string(output));
+        std::thread tuneThread;
+        if (tune) tuneThread = std::thread([&tuner]() { tuner.run(); });
+
         gfx.run();
 
+        tuner.stop();
+        if (tuneThread.joinable()) tuneThread.join();
+
+        audio.effects().report();
+
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;